@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""
+Per-function analysis results cached by binary content hash.
+
+One SQLite file holds the results of every analyzer (native CFG metrics,
+headless Ghidra decompiler statistics, ...) keyed by
+
+    (sha256 of the binary, analyzer name, analyzer version)
+
+so a re-run only analyses binaries that are new or whose bytes changed, and
+a new analyzer version invalidates exactly its own entries. Native analyzers
+derive their version from their source (source_version), so editing the
+decoder or CFG code cannot leave stale rows in use. Rows are
+stored without path-derived columns (task, group, basename), which are
+re-attached from wherever the binary lives now; the same file can be copied
+between machines and caches from several people combined with `merge`.
+
+Commands:
+  stats                          entries per analyzer/version
+  import-ghidra CSV --version V  load a ghidra_statistics.csv run (per binary rows)
+  export --analyzer A --version V --csv OUT
+                                 cached rows for the binaries in output/
+  merge OTHER.sqlite             copy entries missing here from another cache
+"""
+import argparse
+import csv
+import hashlib
+import json
+import sqlite3
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+DEFAULT_CACHE = Path(__file__).parent.parent / "analysis_cache.sqlite"
+GHIDRA_ANALYZER = "ghidra"
+# Columns of ghidra_statistics.csv that describe where the binary was, not what it contains
+GHIDRA_PATH_COLUMNS = ("basename", "binary", "origin", "defense")
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS binaries (
+    sha256      TEXT NOT NULL,
+    analyzer    TEXT NOT NULL,
+    version     TEXT NOT NULL,
+    analyzed_at REAL NOT NULL,
+    seconds     REAL,
+    PRIMARY KEY (sha256, analyzer, version)
+);
+CREATE TABLE IF NOT EXISTS functions (
+    sha256   TEXT NOT NULL,
+    analyzer TEXT NOT NULL,
+    version  TEXT NOT NULL,
+    seq      INTEGER NOT NULL,
+    metrics  TEXT NOT NULL,
+    PRIMARY KEY (sha256, analyzer, version, seq)
+);
+"""
+
+
+def file_sha256(path):
+    with open(path, "rb") as f:
+        return hashlib.file_digest(f, "sha256").hexdigest()
+
+
+def source_version(base, paths):
+    """Analyzer version: a manual base plus a short hash of the source files the analyzer runs."""
+    digest = hashlib.sha256()
+    for path in paths:
+        digest.update(Path(path).read_bytes())
+    return f"{base}-{digest.hexdigest()[:12]}"
+
+
+class AnalysisCache:
+    """SQLite-backed store of per-function result rows."""
+
+    def __init__(self, path=DEFAULT_CACHE):
+        self.path = Path(path)
+        self.db = sqlite3.connect(self.path)
+        self.db.executescript(_SCHEMA)
+
+    def close(self):
+        self.db.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def lookup(self, sha256, analyzer, version):
+        """Cached rows of one binary, or None when it was never analysed."""
+        hit = self.db.execute("SELECT 1 FROM binaries WHERE sha256=? AND analyzer=? AND version=?",
+                              (sha256, analyzer, version)).fetchone()
+        if hit is None:
+            return None
+        cursor = self.db.execute("SELECT metrics FROM functions WHERE sha256=? AND analyzer=? AND version=? "
+                                 "ORDER BY seq", (sha256, analyzer, version))
+        return [json.loads(metrics) for (metrics,) in cursor]
+
+    def store(self, sha256, analyzer, version, rows, seconds=None):
+        """Replace the cached rows of one binary (an empty list is a valid result)."""
+        with self.db:
+            self.db.execute("DELETE FROM functions WHERE sha256=? AND analyzer=? AND version=?",
+                            (sha256, analyzer, version))
+            self.db.execute("INSERT OR REPLACE INTO binaries VALUES (?, ?, ?, ?, ?)",
+                            (sha256, analyzer, version, time.time(), seconds))
+            self.db.executemany("INSERT INTO functions VALUES (?, ?, ?, ?, ?)",
+                                [(sha256, analyzer, version, seq, json.dumps(row))
+                                 for seq, row in enumerate(rows)])
+
+    def stats(self):
+        """(analyzer, version, binaries, rows) for every analyzer in the cache."""
+        return self.db.execute(
+            "SELECT b.analyzer, b.version, COUNT(DISTINCT b.sha256), "
+            "(SELECT COUNT(*) FROM functions f WHERE f.analyzer=b.analyzer AND f.version=b.version) "
+            "FROM binaries b GROUP BY b.analyzer, b.version ORDER BY b.analyzer, b.version").fetchall()
+
+    def merge(self, other_path):
+        """Copy every entry of another cache file that this one does not have; returns binaries added."""
+        self.db.execute("ATTACH DATABASE ? AS other", (str(other_path),))
+        try:
+            with self.db:
+                missing = ("NOT EXISTS (SELECT 1 FROM binaries b WHERE b.sha256=o.sha256 "
+                           "AND b.analyzer=o.analyzer AND b.version=o.version)")
+                self.db.execute(f"INSERT INTO functions SELECT * FROM other.functions o WHERE {missing}")
+                added = self.db.execute(f"INSERT INTO binaries SELECT * FROM other.binaries o WHERE {missing}").rowcount
+        finally:
+            self.db.execute("DETACH DATABASE other")
+        return added
+
+
+def _run(args):
+    analyze, path = args
+    start = time.perf_counter()
+    try:
+        return path, analyze(path), time.perf_counter() - start, None
+    except (ValueError, IndexError, OSError) as e:
+        return path, None, 0.0, str(e)
+
+
+def cached_analysis(files, analyzer, version, analyze, cache, workers=None):
+    """
+    Rows of analyze(path) for every file, running it only on cache misses.
+
+    analyze must be a picklable top-level function returning a list of dicts
+    that depend on the file contents only (cfg_metrics.function_rows, or a
+    wrapper around a headless Ghidra run); misses run in worker processes and
+    are written back as they finish.
+
+    Returns:
+        tuple: ({path: rows}, {path: error}, number of cache hits)
+    """
+    results, errors, misses = {}, {}, []
+    digests = {}
+    for path in files:
+        path = str(path)
+        digests[path] = file_sha256(path)
+        rows = cache.lookup(digests[path], analyzer, version)
+        if rows is None:
+            misses.append(path)
+        else:
+            results[path] = rows
+    hits = len(results)
+    if misses:
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            for path, rows, seconds, error in pool.map(_run, [(analyze, p) for p in misses], chunksize=4):
+                if error:
+                    errors[path] = error
+                    continue
+                cache.store(digests[path], analyzer, version, rows, seconds)
+                results[path] = rows
+    return results, errors, hits
+
+
+def _resolve(name, candidates):
+    """The unique file among candidates called name, or None."""
+    matches = candidates.get(name, [])
+    return matches[0] if len(matches) == 1 else None
+
+
+def import_ghidra(cache, csv_path, version, output_dir=OUTPUT_DIR):
+    """
+    Load ghidra_statistics.csv rows into the cache under the ghidra analyzer.
+
+    The binary column is resolved to a file by an optional path column, or by
+    name when exactly one file under output_dir has that name (point
+    output_dir at output/<task>/<group> for a CSV of one group).
+    """
+    candidates = {}
+    for p in Path(output_dir).rglob("*"):
+        if p.is_file():
+            candidates.setdefault(p.name, []).append(p)
+    by_binary = {}
+    skipped = []
+    with open(csv_path, newline="") as f:
+        for row in csv.DictReader(f):
+            path = Path(row["path"]) if row.get("path") else _resolve(row["binary"], candidates)
+            if path is None or not path.is_file():
+                skipped.append(row["binary"])
+                continue
+            metrics = {k: v for k, v in row.items() if k not in GHIDRA_PATH_COLUMNS and k != "path"}
+            by_binary.setdefault(file_sha256(path), []).append(metrics)
+    for sha256, rows in by_binary.items():
+        cache.store(sha256, GHIDRA_ANALYZER, version, rows)
+    return len(by_binary), skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Content-hash keyed cache of per-function analysis results")
+    parser.add_argument("--cache", type=Path, default=DEFAULT_CACHE)
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("stats")
+    imp = sub.add_parser("import-ghidra")
+    imp.add_argument("csv", type=Path)
+    imp.add_argument("--version", required=True, help="Ghidra version / script revision the CSV came from")
+    imp.add_argument("--output-dir", type=Path, default=OUTPUT_DIR, help="Directory searched for the binaries")
+    exp = sub.add_parser("export")
+    exp.add_argument("--analyzer", required=True)
+    exp.add_argument("--version", required=True)
+    exp.add_argument("--csv", required=True)
+    exp.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    mrg = sub.add_parser("merge")
+    mrg.add_argument("other", type=Path)
+    args = parser.parse_args()
+
+    with AnalysisCache(args.cache) as cache:
+        if args.command == "stats":
+            for analyzer, version, binaries, rows in cache.stats():
+                print(f"{analyzer:<12} {version:<16} {binaries:>6} binaries {rows:>8} rows")
+        elif args.command == "import-ghidra":
+            count, skipped = import_ghidra(cache, args.csv, args.version, args.output_dir)
+            for name in skipped:
+                print(f" [Warning] {name}: no unique binary with this name under {args.output_dir}")
+            print(f"Imported {count} binaries into {args.cache}")
+        elif args.command == "export":
+            from cfg_metrics import describe_binary
+            files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+            rows, missing = [], 0
+            for path in files:
+                cached = cache.lookup(file_sha256(path), args.analyzer, args.version)
+                if cached is None:
+                    missing += 1
+                    continue
+                info = describe_binary(path, args.output_dir)
+                rows.extend({**info, **row} for row in cached)
+            fields = list(dict.fromkeys(k for row in rows for k in row))
+            with open(args.csv, "w", newline="") as f:
+                writer = csv.DictWriter(f, fieldnames=fields)
+                writer.writeheader()
+                writer.writerows(rows)
+            print(f"Exported {len(rows)} rows ({len(files) - missing}/{len(files)} binaries cached) to {args.csv}")
+        elif args.command == "merge":
+            print(f"Added {cache.merge(args.other)} binaries from {args.other}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,9 +1,18 @@
 #!/usr/bin/env python3
 import os
+import re
+import argparse
 import subprocess
 import itertools
+import tempfile
 from pathlib import Path
 import csv
+import ncd
+import block_hash
+import call_graph
+import import_set
+import online_stats
+import result_store
 # --- Configuration ---
 # The base path to your output binaries, relative to the project root
 OUTPUT_DIR = Path("../output")
@@ -21,6 +30,8 @@ VARIANT_SUFFIXES = [
     "_elit",
     "_stripped"
 ]
+# Variant every other variant of the same source is measured against in --mode self
+SELF_REFERENCE_SUFFIX = "_base"
 def run_command(command):
     """Helper function to run a shell command and return its output."""
     try:
@@ -129,10 +140,260 @@ def analyze_radiff2(files, results, task, variant, group):
             "File2": fname2,
             "Score": similarity
         })
-def main():
-    """Main function to run the pilot study."""
-    project_root = Path(__file__).parent.resolve()
-    results = []
+def analyze_ncd(files, results, task, variant, group):
+    """Analyzes pairs of files using normalized compression distance."""
+    print(" [ncd] Comparing all pairs:")
+    if len(files) < 2:
+        return
+    # Each file is compressed once; pairs reuse the first file's primed window.
+    # Groups are only a handful of files, so a process pool would cost more than it saves.
+    for i, j, distance in ncd.pairwise_ncd(files, workers=1):
+        results.append({
+            "Task": task,
+            "Variant": variant,
+            "Group": group,
+            "Tool": "ncd",
+            "File1": Path(files[i]).name,
+            "File2": Path(files[j]).name,
+            "Score": ncd.similarity(distance)
+        })
+def analyze_blockhash(files, results, task, variant, group):
+    """Analyzes pairs of files by the overlap of their layout-independent basic-block hashes."""
+    print(" [blockhash] Hashing each file once, comparing all pairs:")
+    hashes = [block_hash.block_hashes(f) for f in files]
+    for i, j in itertools.combinations(range(len(files)), 2):
+        results.append({
+            "Task": task,
+            "Variant": variant,
+            "Group": group,
+            "Tool": "blockhash",
+            "File1": Path(files[i]).name,
+            "File2": Path(files[j]).name,
+            "Score": block_hash.similarity(hashes[i], hashes[j])
+        })
+def analyze_callgraph(files, results, task, variant, group):
+    """Analyzes pairs of files by the WL subtree kernel of their call graphs."""
+    print(" [callgraph] Extracting each call graph once, comparing all pairs:")
+    if len(files) < 2:
+        return
+    matrix, errors = call_graph.feature_matrix(files, workers=1)
+    for path, error in errors.items():
+        print(f" [Error] callgraph: {path}: {error}")
+    scores = call_graph.similarity_matrix(matrix)
+    for i, j in itertools.combinations(range(len(files)), 2):
+        results.append({
+            "Task": task,
+            "Variant": variant,
+            "Group": group,
+            "Tool": "callgraph",
+            "File1": Path(files[i]).name,
+            "File2": Path(files[j]).name,
+            "Score": float(scores[i, j])
+        })
+def analyze_imports(files, results, task, variant, group):
+    """Analyzes pairs of files by the Jaccard similarity of their import sets."""
+    print(" [imports] Reading each import set once, comparing all pairs:")
+    sets, errors = import_set.import_sets(files, workers=1)
+    for path, error in errors.items():
+        print(f" [Error] imports: {path}: {error}")
+    _, words = import_set.bitsets(sets)
+    scores = import_set.similarity_matrix(words)
+    for i, j in itertools.combinations(range(len(files)), 2):
+        results.append({
+            "Task": task,
+            "Variant": variant,
+            "Group": group,
+            "Tool": "imports",
+            "File1": Path(files[i]).name,
+            "File2": Path(files[j]).name,
+            "Score": float(scores[i, j])
+        })
+# --- Self-similarity under transformation (--mode self) ---
+def program_pairs(group_dir):
+    """(program, base file, variant suffix, variant file) for every source in a group."""
+    pairs = []
+    for base_file in sorted(group_dir.glob(f"*{SELF_REFERENCE_SUFFIX}")):
+        program = base_file.name[:-len(SELF_REFERENCE_SUFFIX)]
+        for suffix in VARIANT_SUFFIXES:
+            if suffix == SELF_REFERENCE_SUFFIX:
+                continue
+            variant_file = group_dir / f"{program}_{suffix.lstrip('_')}"
+            if variant_file.is_file():
+                pairs.append((program, str(base_file), suffix, str(variant_file)))
+    return pairs
+def self_ssdeep(files, pairs):
+    """ssdeep scores for the wanted pairs from one hashing run and one signature-matching run."""
+    print(" [ssdeep] Hashing all files once...")
+    signatures = run_command("ssdeep -s " + " ".join(f'"{f}"' for f in files))
+    if signatures.startswith("ERROR"):
+        print(f" {signatures}")
+        return {}
+    with tempfile.NamedTemporaryFile("w", suffix=".ssdeep", delete=False) as sigfile:
+        sigfile.write(signatures + "\n")
+    # -x compares every signature in the file against every other one
+    output = run_command(f'ssdeep -a -s -x "{sigfile.name}"')
+    os.remove(sigfile.name)
+    scores = {}
+    for line in output.splitlines():
+        match = re.search(r'(\S+) matches (\S+) \((\d+)\)', line.replace('"', ''))
+        if match:
+            name1, name2 = Path(match.group(1)).name, Path(match.group(2)).name
+            scores[(name1, name2)] = scores[(name2, name1)] = int(match.group(3))
+    return {pair: scores.get((Path(pair[0]).name, Path(pair[1]).name), 0) for pair in pairs}
+def self_sdhash(files, pairs):
+    """sdhash scores for the wanted pairs from one digest run and one reference comparison."""
+    print(" [sdhash] Digesting all files once...")
+    digests = {}
+    for line in run_command("sdhash " + " ".join(f'"{f}"' for f in files)).splitlines():
+        fields = line.split(":")
+        if line.startswith("sdbf") and len(fields) > 3:
+            digests[Path(line[len(":".join(fields[:3])) + 1:][:int(fields[2])]).name] = line
+    if not digests:
+        print(" [Error] sdhash produced no digests.")
+        return {}
+    bases = sorted({Path(b).name for b, _ in pairs})
+    variants = sorted({Path(v).name for _, v in pairs})
+    with tempfile.TemporaryDirectory() as tmp:
+        base_path, variant_path = Path(tmp) / "base.sdbf", Path(tmp) / "variant.sdbf"
+        base_path.write_text("\n".join(digests[n] for n in bases if n in digests) + "\n")
+        variant_path.write_text("\n".join(digests[n] for n in variants if n in digests) + "\n")
+        output = run_command(f'sdhash -c "{base_path}" "{variant_path}" -t 0 --separator csv')
+    scores = {}
+    for line in output.splitlines():
+        parts = line.split(',')
+        if len(parts) == 3:
+            scores[(Path(parts[0].strip()).name, Path(parts[1].strip()).name)] = parts[2].strip()
+    return {pair: scores.get((Path(pair[0]).name, Path(pair[1]).name), 0) for pair in pairs}
+def self_radiff2(files, pairs):
+    """radiff2 has no digest form, so each wanted pair is diffed directly."""
+    print(" [radiff2] Comparing base against each variant:")
+    scores = {}
+    for file1, file2 in pairs:
+        similarity = "N/A"
+        for line in run_command(f'radiff2 -s "{file1}" "{file2}"').split('\n'):
+            if "similarity" in line:
+                try:
+                    similarity = float(line.split()[1])
+                    break
+                except (ValueError, IndexError):
+                    similarity = "Parse Error"
+        scores[(file1, file2)] = similarity
+    return scores
+def self_ncd(files, pairs):
+    """NCD with each base compressed once and reused as the primed window for its variants."""
+    print(" [ncd] Compressing each base once:")
+    scores = {}
+    for base, group_pairs in itertools.groupby(sorted(pairs), key=lambda pair: pair[0]):
+        base_data = Path(base).read_bytes()
+        base_size = ncd.compressed_size(base_data)
+        primed = ncd.PrimedCompressor(base_data)
+        for _, variant in group_pairs:
+            variant_data = Path(variant).read_bytes()
+            distance = ncd.ncd(base_size, ncd.compressed_size(variant_data), primed.joint_size(variant_data))
+            scores[(base, variant)] = ncd.similarity(distance)
+    return scores
+def self_blockhash(files, pairs):
+    """Block-set similarity with every file hashed once."""
+    print(" [blockhash] Hashing each file once:")
+    hashes = {f: block_hash.block_hashes(f) for f in files}
+    return {(base, variant): block_hash.similarity(hashes[base], hashes[variant]) for base, variant in pairs}
+def self_callgraph(files, pairs):
+    """Call-graph kernel similarity from one histogram per file."""
+    print(" [callgraph] Extracting each call graph once:")
+    matrix, errors = call_graph.feature_matrix(files, workers=1)
+    for path, error in errors.items():
+        print(f" [Error] callgraph: {path}: {error}")
+    scores = call_graph.similarity_matrix(matrix)
+    row = {str(f): i for i, f in enumerate(files)}
+    return {(base, variant): float(scores[row[str(base)], row[str(variant)]]) for base, variant in pairs}
+def self_imports(files, pairs):
+    """Import-set Jaccard from one bitset per file."""
+    print(" [imports] Reading each import set once:")
+    sets, errors = import_set.import_sets(files, workers=1)
+    for path, error in errors.items():
+        print(f" [Error] imports: {path}: {error}")
+    _, words = import_set.bitsets(sets)
+    scores = import_set.similarity_matrix(words)
+    row = {str(f): i for i, f in enumerate(files)}
+    return {(base, variant): float(scores[row[str(base)], row[str(variant)]]) for base, variant in pairs}
+SELF_TOOLS = {
+    "ssdeep": self_ssdeep,
+    "sdhash": self_sdhash,
+    "radiff2": self_radiff2,
+    "ncd": self_ncd,
+    "blockhash": self_blockhash,
+    "callgraph": self_callgraph,
+    "imports": self_imports,
+}
+def to_distance(tool, score):
+    """Turn a similarity score into a 0-100 distance (radiff2 reports 0-1)."""
+    try:
+        value = float(score)
+    except (TypeError, ValueError):
+        return ""
+    if tool == "radiff2":
+        value *= 100
+    return round(100 - value, 3)
+def write_defense_distance(rows, path):
+    """Pivot the self-similarity rows into one line per (task, group, program, tool)."""
+    variants = [v for v in VARIANT_SUFFIXES if v != SELF_REFERENCE_SUFFIX]
+    table = {}
+    for row in rows:
+        key = (row["Task"], row["Group"], row["Program"], row["Tool"])
+        table.setdefault(key, {})[row["Variant"]] = to_distance(row["Tool"], row["Score"])
+    with open(path, "w", newline="") as csvfile:
+        writer = csv.writer(csvfile)
+        writer.writerow(["Task", "Group", "Program", "Tool"] + variants)
+        for key in sorted(table):
+            writer.writerow(list(key) + [table[key].get(v, "") for v in variants])
+def run_self_similarity(project_root):
+    """Score every source's base binary against each of its own variants, for all tools."""
+    rows = []
+    for output_path in OUTPUT_PATHS:
+        print("===========================================================")
+        print(f" Self-Similarity Under Transformation")
+        print(f" Task: {output_path.name}")
+        print("===========================================================")
+        for group in GROUPS:
+            print(f"--- Analyzing Group: {group} ---")
+            group_dir = project_root / output_path / group
+            if not group_dir.is_dir():
+                print(f" [Error] Directory not found: {group_dir}. Skipping.")
+                print()
+                continue
+            pairs = program_pairs(group_dir)
+            if not pairs:
+                print(f" [Warning] No '{SELF_REFERENCE_SUFFIX}' binaries with variants in '{group}'. Skipping.")
+                print()
+                continue
+            files = sorted({f for _, base, _, variant in pairs for f in (base, variant)})
+            file_pairs = [(base, variant) for _, base, _, variant in pairs]
+            print(f" Found {len(files)} files, {len(pairs)} base/variant pairs.")
+            for tool, compare in SELF_TOOLS.items():
+                scores = compare(files, file_pairs)
+                for program, base, suffix, variant in pairs:
+                    rows.append({
+                        "Task": output_path.name,
+                        "Group": group,
+                        "Program": program,
+                        "Tool": tool,
+                        "Variant": suffix,
+                        "File1": Path(base).name,
+                        "File2": Path(variant).name,
+                        "Score": scores.get((base, variant), "N/A")
+                    })
+            print("-------------------------------------")
+            print()
+    with open("self_similarity_results.csv", "w", newline="") as csvfile:
+        writer = csv.DictWriter(csvfile, fieldnames=["Task", "Group", "Program", "Tool", "Variant", "File1", "File2", "Score"])
+        writer.writeheader()
+        writer.writerows(rows)
+    write_defense_distance(rows, "defense_distance.csv")
+    print("Self-similarity analysis complete. Defense-distance table: defense_distance.csv")
+def run_intra_origin(project_root):
+    """Compare all files of the same variant within each origin group."""
+    # Every appended row also updates the live per-(task, variant, group, tool) statistics
+    results = online_stats.StreamingResults(online_stats.OnlineAggregator())
     for output_path in OUTPUT_PATHS:
         print("===========================================================")
         print(f" Pilot Study: Intra-Origin Similarity Analysis (Python)")
@@ -168,12 +429,31 @@ def main():
                 analyze_sdhash(files_to_analyze, results, output_path.name, variant_suffix, group)
                 print()
                 analyze_radiff2(files_to_analyze, results, output_path.name, variant_suffix, group)
+                print()
+                analyze_ncd(files_to_analyze, results, output_path.name, variant_suffix, group)
+                print()
+                analyze_blockhash(files_to_analyze, results, output_path.name, variant_suffix, group)
+                print()
+                analyze_callgraph(files_to_analyze, results, output_path.name, variant_suffix, group)
+                print()
+                analyze_imports(files_to_analyze, results, output_path.name, variant_suffix, group)
                 print("-------------------------------------")
                 print()
-    with open("analysis_results.csv", "w", newline="") as csvfile:
-        writer = csv.DictWriter(csvfile, fieldnames=["Task", "Variant", "Group", "Tool", "File1", "File2", "Score"])
-        writer.writeheader()
-        writer.writerows(results)
-    print("Pilot study complete.")
+    # Typed columnar file (failed comparisons kept as missing); `result_store.py to-csv` exports a CSV
+    result_store.write(result_store.RESULTS_FILE, results)
+    results.aggregator.flush(verbose=False)
+    print(f"Pilot study complete. Results: {result_store.RESULTS_FILE}, "
+          f"summary: {online_stats.LIVE_CSV}, state: {online_stats.STATE_FILE}")
+def main():
+    """Main function to run the pilot study."""
+    parser = argparse.ArgumentParser(description="Binary similarity analysis")
+    parser.add_argument("--mode", choices=["intra", "self"], default="intra",
+                        help="intra: all pairs per variant and group; self: each base against its own variants")
+    args = parser.parse_args()
+    project_root = Path(__file__).parent.resolve()
+    if args.mode == "self":
+        run_self_similarity(project_root)
+    else:
+        run_intra_origin(project_root)
 if __name__ == "__main__":
     main()
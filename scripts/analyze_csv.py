@@ -8,9 +8,12 @@ import pandas as pd
 import numpy as np
 import matplotlib.pyplot as plt
 import seaborn as sns
-from scipy import stats
 import os
 import warnings
+import group_by
+import rank_engine
+import resampling
+import result_store
 warnings.filterwarnings('ignore')
 # Set style for professional academic plots
 plt.style.use('seaborn-v0_8-whitegrid')
@@ -20,6 +23,7 @@ class MTDAnalyzer:
         self.data_path = data_path
         self.output_dir = output_dir
         self.df = None
+        self.table = None
         self.results = {}
        
         # Create output directory
@@ -28,20 +32,11 @@ class MTDAnalyzer:
         os.makedirs(os.path.join(output_dir, 'tables'), exist_ok=True)
        
     def load_and_clean_data(self):
-        """Load CSV data and perform basic cleaning"""
+        """Load the columnar results file (or a CSV) and perform basic cleaning"""
         print("Loading data...")
-        self.df = pd.read_csv(self.data_path)
-       
-        # Convert scores to numeric
-        def convert_score(score):
-            try:
-                if isinstance(score, str) and score.startswith('0'):
-                    return float(score.lstrip('0')) if score.lstrip('0') else 0.0
-                return float(score)
-            except:
-                return 0.0
-       
-        self.df['Score'] = self.df['Score'].apply(convert_score)
+        # Scores are already floats (unparsable ones read as 0.0), see result_store.ResultTable.scores
+        self.table = result_store.ResultTable(self.data_path)
+        self.df = self.table.to_dataframe()
        
         # Normalize radiff2 scores (0-1 scale to 0-100)
         radiff2_mask = self.df['Tool'] == 'radiff2'
@@ -73,6 +68,16 @@ class MTDAnalyzer:
        
         return summary
    
+    def mann_whitney_by_tool(self, variants):
+        """Human vs LLM Mann-Whitney (U, p) per tool over the given variants, as scipy's two-sided test"""
+        group_sample = group_by.remap_codes(self.table.categories('Group'), [['gemini', 'gpt5'], ['human']])
+        in_variants = self.table.mask(Variant=list(variants))
+        sample = np.where(in_variants, group_sample[self.table.codes('Group')], -1)
+        tools = self.table.categories('Tool')
+        # Ranks are taken within each tool, so the stored (un-rescaled radiff2) scores give the same tests
+        result = rank_engine.mann_whitney(self.table.scores, sample, self.table.codes('Tool'), len(tools))
+        return {tool: (result['u'][i], result['p'][i]) for i, tool in enumerate(tools)}
+   
     def analyze_baseline_differences(self):
         """Analyze baseline differences between human and LLM code using Mann-Whitney U test"""
         print("\nAnalyzing baseline differences (Mann-Whitney U test)...")
@@ -106,6 +111,8 @@ class MTDAnalyzer:
        
         # Mann-Whitney U tests for baseline differences (non-parametric)
         baseline_stats = {}
+        # U and p of every tool from one radix sort of the scores
+        tests = self.mann_whitney_by_tool(baseline_variants)
         for tool in baseline_data['Tool'].unique():
             human_scores = baseline_data[(baseline_data['Group'] == 'human') &
                                        (baseline_data['Tool'] == tool)]['Score']
@@ -116,16 +123,23 @@ class MTDAnalyzer:
                 continue
            
             # Use Mann-Whitney U test (non-parametric)
-            u_stat, p_value = stats.mannwhitneyu(human_scores, llm_scores, alternative='two-sided')
+            u_stat, p_value = tests[tool]
            
             # Calculate effect size (rank-biserial correlation)
             n1, n2 = len(human_scores), len(llm_scores)
             rbc = 1 - (2 * u_stat) / (n1 * n2) # rank-biserial correlation
            
+            # Bootstrap CI of the effect and a permutation p-value (10k replicates each)
+            intervals = resampling.mann_whitney_intervals(human_scores, llm_scores,
+                                                          seed=resampling.seed_for('baseline', tool))
+           
             baseline_stats[tool] = {
                 'u_statistic': u_stat,
                 'p_value': p_value,
                 'effect_size_rbc': rbc,
+                'rbc_ci_low': intervals['rbc_ci_low'],
+                'rbc_ci_high': intervals['rbc_ci_high'],
+                'p_permutation': intervals['p_permutation'],
                 'significant': p_value < 0.05
             }
        
@@ -145,58 +159,9 @@ class MTDAnalyzer:
         baseline_variants = ['_base', 'O0']
         defense_variants = ['_clang_O2', '_O3', '_cff', '_elit', '_stripped']
        
-        defense_effectiveness = {}
-       
-        for group in self.df['Group'].unique():
-            group_effectiveness = {}
-           
-            for tool in self.df['Tool'].unique():
-                # Calculate baseline average for this group and tool
-                baseline_scores = self.df[(self.df['Group'] == group) &
-                                        (self.df['Variant'].isin(baseline_variants)) &
-                                        (self.df['Tool'] == tool)]['Score']
-                baseline_mean = baseline_scores.mean() if len(baseline_scores) > 0 else np.nan
-               
-                # Calculate effectiveness for each defense variant
-                defense_metrics = {}
-                for variant in defense_variants:
-                    defense_scores = self.df[(self.df['Group'] == group) &
-                                           (self.df['Variant'] == variant) &
-                                           (self.df['Tool'] == tool)]['Score']
-                    defense_mean = defense_scores.mean() if len(defense_scores) > 0 else np.nan
-                   
-                    if np.isnan(baseline_mean) or np.isnan(defense_mean):
-                        continue
-                   
-                    absolute_reduction = baseline_mean - defense_mean
-                    percent_reduction = (absolute_reduction / baseline_mean) * 100 if baseline_mean > 0 else 0
-                   
-                    defense_metrics[variant] = {
-                        'baseline_score': baseline_mean,
-                        'defense_score': defense_mean,
-                        'absolute_reduction': absolute_reduction,
-                        'percent_reduction': percent_reduction
-                    }
-               
-                group_effectiveness[tool] = defense_metrics
-           
-            defense_effectiveness[group] = group_effectiveness
-       
-        # Create comprehensive effectiveness table
-        effectiveness_data = []
-        for group in defense_effectiveness:
-            for tool in defense_effectiveness[group]:
-                for variant in defense_effectiveness[group][tool]:
-                    metrics = defense_effectiveness[group][tool][variant]
-                    effectiveness_data.append({
-                        'Group': group,
-                        'Tool': tool,
-                        'Variant': variant,
-                        'Baseline_Score': metrics['baseline_score'],
-                        'Defense_Score': metrics['defense_score'],
-                        'Absolute_Reduction': metrics['absolute_reduction'],
-                        'Percent_Reduction': metrics['percent_reduction']
-                    })
+        # One grouping pass over the category codes gives every (group, tool, variant) mean
+        effectiveness_data = group_by.defense_effectiveness(
+            self.table, self.df['Score'].to_numpy(), baseline_variants, defense_variants)
        
         effectiveness_df = pd.DataFrame(effectiveness_data)
         effectiveness_df.to_csv(os.path.join(self.output_dir, 'tables', 'defense_effectiveness.csv'), index=False)
@@ -238,6 +203,8 @@ class MTDAnalyzer:
        
         # Mann-Whitney U tests for final resilience (non-parametric)
         final_stats = {}
+        # U and p of every tool from one radix sort of the scores
+        tests = self.mann_whitney_by_tool(top_defenses)
         for tool in resilience_data['Tool'].unique():
             human_scores = resilience_data[(resilience_data['Group'] == 'human') &
                                          (resilience_data['Tool'] == tool)]['Score']
@@ -248,16 +215,23 @@ class MTDAnalyzer:
                 continue
            
             # Use Mann-Whitney U test (non-parametric)
-            u_stat, p_value = stats.mannwhitneyu(human_scores, llm_scores, alternative='two-sided')
+            u_stat, p_value = tests[tool]
            
             # Calculate effect size (rank-biserial correlation)
             n1, n2 = len(human_scores), len(llm_scores)
             rbc = 1 - (2 * u_stat) / (n1 * n2) # rank-biserial correlation
            
+            # Bootstrap CI of the effect and a permutation p-value (10k replicates each)
+            intervals = resampling.mann_whitney_intervals(human_scores, llm_scores,
+                                                          seed=resampling.seed_for('final', tool))
+           
             final_stats[tool] = {
                 'u_statistic': u_stat,
                 'p_value': p_value,
                 'effect_size_rbc': rbc,
+                'rbc_ci_low': intervals['rbc_ci_low'],
+                'rbc_ci_high': intervals['rbc_ci_high'],
+                'p_permutation': intervals['p_permutation'],
                 'significant': p_value < 0.05
             }
        
@@ -340,8 +314,9 @@ class MTDAnalyzer:
         plt.close()
        
         # 6. Distribution plots for each tool (to show non-normality)
-        fig, axes = plt.subplots(1, 3, figsize=(15, 5))
         tools = self.df['Tool'].unique()
+        fig, axes = plt.subplots(1, len(tools), figsize=(5 * len(tools), 5), squeeze=False)
+        axes = axes[0]
        
         for i, tool in enumerate(tools):
             tool_data = self.df[self.df['Tool'] == tool]
@@ -468,7 +443,7 @@ def main():
     """Main execution function"""
     # Updated paths for Ubuntu desktop
     base_dir = os.path.expanduser("~/Desktop/mtd_llm_research")
-    data_path = os.path.join(base_dir, "scripts", "analysis_results.csv")
+    data_path = os.path.join(base_dir, "scripts", result_store.RESULTS_FILE)
     output_dir = os.path.join(base_dir, "results")
    
     analyzer = MTDAnalyzer(data_path, output_dir)
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""
+Accuracy and speed benchmark for the similarity tools used by analyze_binaries.py.
+
+Runs every available tool over the ground-truth fixtures in test/ plus synthetic
+mutations of test/file1, then checks the scores against expected relations and
+reports throughput:
+
+  fixtures   file1 / file3      same source, rebuilt
+             file1 / file2      slightly edited source
+             file1 / file1_O2   same source, re-optimized
+  mutations  byte flips (0.1%, 1%, 5%), 4 KB page shuffle, zero padding,
+             and a random file of the same size as the unrelated floor
+
+The tools are driven through the analyze_* functions of analyze_binaries.py, so
+the exact pipeline code is measured. Exits non-zero when an expectation fails,
+so it can gate tool or implementation changes.
+"""
+import argparse
+import contextlib
+import csv
+import io
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+import analyze_binaries
+import block_hash
+import call_graph
+import import_set
+import ncd
+import sdhash_index
+
+# --- Configuration ---
+TEST_DIR = Path(__file__).parent.parent / "test"
+FIXTURES = ["file1", "file2", "file3", "file1_O2"]
+SEED = 1337
+FLIP_RATES = [0.001, 0.01, 0.05]
+PAGE_SIZE = 4096
+PADDING = 4096
+# Similarity a byte-identical copy must reach on the 0-100 scale
+# (compressors leave NCD(x, x) around 0.05, so this is not 100)
+IDENTITY_MIN = 90
+# Highest similarity tolerated against unrelated random bytes
+UNRELATED_MAX = 10
+# Tools that read the ELF through its section headers: page_shuffle moves the
+# sections away from the offsets those give, so the file no longer parses
+ELF_PARSERS = {"callgraph", "imports"}
+
+# Tool name -> (pipeline function, external command it needs or None)
+TOOLS = {
+    "ssdeep": (analyze_binaries.analyze_ssdeep, "ssdeep"),
+    "sdhash": (analyze_binaries.analyze_sdhash, "sdhash"),
+    "radiff2": (analyze_binaries.analyze_radiff2, "radiff2"),
+    "ncd": (analyze_binaries.analyze_ncd, None),
+    "blockhash": (analyze_binaries.analyze_blockhash, None),
+    "callgraph": (analyze_binaries.analyze_callgraph, None),
+    "imports": (analyze_binaries.analyze_imports, None),
+}
+
+
+def digest_ssdeep(files):
+    subprocess.run(["ssdeep", "-s", *map(str, files)], check=True, capture_output=True)
+
+
+def digest_sdhash(files):
+    subprocess.run(["sdhash", *map(str, files)], check=True, capture_output=True)
+
+
+def digest_ncd(files):
+    for f in files:
+        ncd.compressed_size(Path(f).read_bytes())
+
+
+def digest_blockhash(files):
+    for f in files:
+        block_hash.block_hashes(f)
+
+
+def digest_callgraph(files):
+    call_graph.feature_matrix(files, workers=1)
+
+
+def digest_imports(files):
+    import_set.import_sets(files, workers=1)
+
+
+# Tools with a separate digest step; radiff2 only works on pairs
+DIGESTERS = {"ssdeep": digest_ssdeep, "sdhash": digest_sdhash, "ncd": digest_ncd, "blockhash": digest_blockhash,
+             "callgraph": digest_callgraph, "imports": digest_imports}
+
+
+def make_mutations(source, out_dir, rng):
+    """Write the synthetic variants of a binary; returns {case: path}."""
+    data = source.read_bytes()
+    cases = {}
+
+    def emit(name, payload):
+        path = out_dir / name
+        path.write_bytes(payload)
+        cases[name] = path
+
+    emit("copy", data)
+    for rate in FLIP_RATES:
+        mutated = bytearray(data)
+        for pos in rng.sample(range(len(data)), max(1, int(len(data) * rate))):
+            mutated[pos] ^= 0xFF
+        emit(f"flip_{rate:g}", bytes(mutated))
+    pages = [data[i:i + PAGE_SIZE] for i in range(0, len(data), PAGE_SIZE)]
+    # Keep the ELF header page in place, shuffle the section pages behind it
+    tail = pages[1:]
+    rng.shuffle(tail)
+    emit("page_shuffle", b"".join([pages[0]] + tail))
+    emit("padding", data + b"\0" * PADDING)
+    emit("unrelated", bytes(rng.getrandbits(8) for _ in range(len(data))))
+    return cases
+
+
+def normalize(tool, score):
+    """Scores on the 0-100 scale used by analyze_csv.py; failures count as 0."""
+    try:
+        value = float(score)
+    except (TypeError, ValueError):
+        return 0.0
+    return value * 100 if tool == "radiff2" else value
+
+
+def run_tool(tool, files):
+    """All-pairs scores through the pipeline function, with its wall time."""
+    function, _ = TOOLS[tool]
+    results = []
+    start = time.perf_counter()
+    with contextlib.redirect_stdout(io.StringIO()):
+        function([str(f) for f in files], results, "bench", "", "fixtures")
+    elapsed = time.perf_counter() - start
+    scores = {}
+    for row in results:
+        value = normalize(tool, row["Score"])
+        scores[(row["File1"], row["File2"])] = scores[(row["File2"], row["File1"])] = value
+    return scores, elapsed
+
+
+def expectations(score, parses_elf=False):
+    """(description, passed) for every ground-truth relation; score(a, b) looks up a pair."""
+    flips = [score("file1", f"flip_{rate:g}") for rate in FLIP_RATES]
+    unrelated = score("file1", "unrelated")
+    checks = [
+        (f"identical copy >= {IDENTITY_MIN}", score("file1", "copy") >= IDENTITY_MIN),
+        ("rebuilt (file1/file3) >= edited (file1/file2)", score("file1", "file3") >= score("file1", "file2")),
+        ("edited (file1/file2) >= re-optimized (file1/file1_O2)",
+         score("file1", "file2") >= score("file1", "file1_O2")),
+        ("byte flips degrade monotonically", all(a >= b for a, b in zip(flips, flips[1:]))),
+        (f"unrelated bytes <= {UNRELATED_MAX}", unrelated <= UNRELATED_MAX),
+    ]
+    for case in ("padding", "flip_0.001") if parses_elf else ("page_shuffle", "padding", "flip_0.001"):
+        checks.append((f"{case} scores above unrelated", score("file1", case) > unrelated))
+    return checks
+
+
+def check_stored_sdhash():
+    """Fresh sdhash digests of the fixtures must match the stored .sdhash files bit for bit."""
+    checks = []
+    for stored in sorted(TEST_DIR.glob("*.sdhash")):
+        binary = stored.with_suffix("")
+        fresh = subprocess.run(["sdhash", str(binary)], check=True, text=True, capture_output=True).stdout
+        _, fresh_filters = sdhash_index.parse_sdbf(fresh.splitlines()[0])
+        _, stored_filters = sdhash_index.parse_sdbf(stored.read_text().splitlines()[0])
+        same = fresh_filters.shape == stored_filters.shape and (fresh_filters == stored_filters).all()
+        checks.append((f"digest of {binary.name} matches {stored.name}", bool(same)))
+    return checks
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Similarity tool accuracy and speed benchmark")
+    parser.add_argument("--tools", nargs="+", choices=list(TOOLS), default=list(TOOLS))
+    parser.add_argument("--csv", help="Append one row per tool to this CSV for tracking over time")
+    args = parser.parse_args()
+
+    rng = random.Random(SEED)
+    failures = 0
+    summary = []
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp = Path(tmp)
+        files = []
+        for name in FIXTURES:
+            shutil.copy2(TEST_DIR / name, tmp / name)
+            files.append(tmp / name)
+        files += list(make_mutations(TEST_DIR / "file1", tmp, rng).values())
+        total_bytes = sum(f.stat().st_size for f in files)
+        n_pairs = len(files) * (len(files) - 1) // 2
+        print(f"Benchmark set: {len(files)} files, {total_bytes / 1e6:.2f} MB, {n_pairs} pairs")
+
+        for tool in args.tools:
+            _, command = TOOLS[tool]
+            print("\n" + "=" * 25)
+            print(f" TOOL: {tool}")
+            print("=" * 25)
+            if command and not shutil.which(command):
+                print(f" [Warning] '{command}' not found on PATH. Skipping.")
+                continue
+
+            digest_rate = None
+            if tool in DIGESTERS:
+                start = time.perf_counter()
+                DIGESTERS[tool](files)
+                digest_rate = total_bytes / 1e6 / (time.perf_counter() - start)
+
+            scores, elapsed = run_tool(tool, files)
+            checks = expectations(lambda a, b: 100.0 if a == b else scores.get((a, b), 0.0), tool in ELF_PARSERS)
+            if tool == "sdhash":
+                checks += check_stored_sdhash()
+
+            passed = sum(ok for _, ok in checks)
+            failures += len(checks) - passed
+            for description, ok in checks:
+                print(f" [{'PASS' if ok else 'FAIL'}] {description}")
+            pair_rate = n_pairs / elapsed
+            digest_text = f"{digest_rate:.2f} MB/s digested, " if digest_rate else ""
+            print(f" {passed}/{len(checks)} expectations met; {digest_text}{pair_rate:,.0f} pairs/s compared")
+            summary.append({
+                "Tool": tool,
+                "Passed": passed,
+                "Checks": len(checks),
+                "Digest_MBps": round(digest_rate, 3) if digest_rate else "",
+                "Pairs_per_s": round(pair_rate, 1),
+            })
+
+    if args.csv and summary:
+        new_file = not Path(args.csv).exists()
+        with open(args.csv, "a", newline="") as csvfile:
+            writer = csv.DictWriter(csvfile, fieldnames=["Timestamp"] + list(summary[0]))
+            if new_file:
+                writer.writeheader()
+            stamp = time.strftime("%Y-%m-%dT%H:%M:%S")
+            writer.writerows({"Timestamp": stamp, **row} for row in summary)
+
+    print("\nBenchmark complete." if not failures else f"\n[FAIL] {failures} expectation(s) not met.")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Position-independent basic-block hashes and the block-set similarity score.
+
+Every variant is linked as a PIE, and a different layout moves code and data,
+which rewrites every rip-relative displacement and call/jump offset even when
+the instructions are the same. Byte-level tools count that as dissimilarity.
+Here .text is decoded in one linear sweep; in each instruction the
+layout-dependent bytes are zeroed before hashing:
+
+  - rip-relative displacements
+  - relative branch and call offsets
+  - displacements and immediates that point into the image (absolute
+    addresses; only meaningful for non-PIE images loaded above 64 KB)
+  - optionally every other immediate (mask_immediates=True)
+
+nop/int3 padding is skipped. Blocks end after jumps, returns and hlt/ud2 and
+start at every direct branch target, and each block's masked bytes are hashed
+with 64-bit BLAKE2b. Two binaries are compared by the Jaccard index of their
+block-hash sets, scaled to 0-100 like the other tools.
+
+Files without a usable section table (damaged or non-ELF input) are swept
+whole, so any executable bytes they contain can still match.
+"""
+import argparse
+import hashlib
+import itertools
+import struct
+from pathlib import Path
+
+import numpy as np
+
+import elf_utils
+import x86_decode as X
+
+# --- Configuration ---
+HASH_SIZE = 8
+# Lowest load address treated as a non-PIE image whose absolute addresses are masked
+MIN_ABSOLUTE_BASE = 0x10000
+
+_BLOCK_END = frozenset([X.FLOW_JMP, X.FLOW_JCC, X.FLOW_RET, X.FLOW_JMP_IND, X.FLOW_STOP, X.FLOW_BAD])
+_RELATIVE = frozenset([X.FLOW_JMP, X.FLOW_JCC, X.FLOW_CALL])
+
+
+def code_regions(path):
+    """
+    Code to hash as (bytes, virtual address) pairs plus the image address range.
+
+    .text when present, otherwise every executable section, otherwise the
+    whole file.
+    """
+    data = Path(path).read_bytes()
+    try:
+        elf = elf_utils.ELFFile(path)
+        text = elf.section(".text")
+        sections = [text] if text is not None and text.size else elf.executable_sections()
+        mapped = [s for s in elf.sections if s.addr]
+    except (ValueError, IndexError, struct.error):
+        sections = mapped = []
+    if not sections:
+        return [(memoryview(data), 0)], (0, len(data))
+    lo = min(s.addr for s in mapped)
+    hi = max(s.addr + s.size for s in mapped)
+    return [(elf.section_bytes(s), s.addr) for s in sections], (lo, hi)
+
+
+def _masked(code, offset, insn, image, mask_immediates):
+    """Instruction bytes with the layout-dependent fields zeroed."""
+    raw = bytearray(code[offset:offset + insn.size])
+    lo, hi = image
+    absolute = lo >= MIN_ABSOLUTE_BASE
+    if insn.disp_size and (insn.rip_relative or (absolute and lo <= insn.disp < hi)):
+        raw[insn.disp_off:insn.disp_off + insn.disp_size] = bytes(insn.disp_size)
+    if insn.imm_size and (insn.flow in _RELATIVE or mask_immediates or (absolute and lo <= insn.imm < hi)):
+        raw[insn.imm_off:insn.imm_off + insn.imm_size] = bytes(insn.imm_size)
+    return bytes(raw)
+
+
+def region_blocks(code, addr, image, mask_immediates=False):
+    """(hash, instructions) of the basic blocks of one code region, in address order."""
+    insns = list(X.sweep(code, addr))
+    end = addr + len(code)
+    leaders = {insn.target for insn in insns
+               if insn.flow in (X.FLOW_JMP, X.FLOW_JCC) and insn.target is not None and addr <= insn.target < end}
+
+    blocks = []
+    block = hashlib.blake2b(digest_size=HASH_SIZE)
+    members = []
+    for insn in insns:
+        if insn.addr in leaders and members:
+            blocks.append((block.digest(), members))
+            block = hashlib.blake2b(digest_size=HASH_SIZE)
+            members = []
+        if insn.is_nop or (insn.map == X.MAP_1BYTE and insn.opcode == 0xCC):
+            continue
+        block.update(_masked(code, insn.addr - addr, insn, image, mask_immediates))
+        members.append(insn)
+        if insn.flow in _BLOCK_END:
+            blocks.append((block.digest(), members))
+            block = hashlib.blake2b(digest_size=HASH_SIZE)
+            members = []
+    if members:
+        blocks.append((block.digest(), members))
+    return blocks
+
+
+def region_block_hashes(code, addr, image, mask_immediates=False):
+    """Hashes of the basic blocks of one code region, in address order."""
+    return [digest for digest, _ in region_blocks(code, addr, image, mask_immediates)]
+
+
+def block_hashes(path, mask_immediates=False):
+    """Sorted unique block hashes of a binary as a uint64 array."""
+    regions, image = code_regions(path)
+    digests = b"".join(d for code, addr in regions for d in region_block_hashes(code, addr, image, mask_immediates))
+    return np.unique(np.frombuffer(digests, dtype=np.uint64))
+
+
+def jaccard(a, b):
+    """Jaccard index of two sorted unique hash arrays."""
+    if not len(a) and not len(b):
+        return 1.0
+    shared = len(np.intersect1d(a, b, assume_unique=True))
+    return shared / (len(a) + len(b) - shared)
+
+
+def similarity(a, b):
+    """Block-set similarity on the 0-100 scale of the other tools."""
+    return round(100 * jaccard(a, b), 2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Layout-independent basic-block similarity of binaries")
+    parser.add_argument("files", nargs="+", type=Path)
+    parser.add_argument("--mask-immediates", action="store_true", help="Also mask non-address immediates")
+    args = parser.parse_args()
+
+    hashes = {f: block_hashes(f, args.mask_immediates) for f in args.files}
+    for f, h in hashes.items():
+        print(f"{f}: {len(h)} distinct blocks")
+    for a, b in itertools.combinations(args.files, 2):
+        print(f"{a.name} vs {b.name}: {similarity(hashes[a], hashes[b])}")
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,8 @@ import shutil
 import time
 from pathlib import Path
 
+from source_store import SourceStore
+
 # --- CONFIGURATION ---
 # Define the project root directory relative to this script's location
 PROJECT_ROOT = Path(__file__).parent.parent
@@ -12,6 +14,8 @@ PROJECT_ROOT = Path(__file__).parent.parent
 # Directories relative to the project root
 CORPUS_DIR = PROJECT_ROOT / "corpus"
 OUTPUT_DIR = PROJECT_ROOT / "output"
+# Tigress outputs are kept here (content-addressed) instead of being deleted
+SOURCE_STORE = PROJECT_ROOT / "transformed_sources.sqlite"
 
 # List of tasks to process (uncomment as needed)
 TASKS_TO_PROCESS = [
@@ -103,65 +107,74 @@ def main():
         print("[WARNING] No source files found to process. Exiting.")
         return
 
-    for source_path in source_files_to_process:
-        print(f"\n[+] Processing Source File: {source_path}")
-        relative_path = source_path.relative_to(CORPUS_DIR)
-        output_base_dir = OUTPUT_DIR / relative_path.parent
-        base_name = source_path.stem
-        output_base_dir.mkdir(parents=True, exist_ok=True)
-
-        # --- Baseline Variant ---
-        baseline_path = output_base_dir / f"{base_name}_base"
-        run_command(["gcc", "-O2", "-pie", str(source_path), "-o", str(baseline_path)], "Building baseline")
-
-        # --- Optimization Variants ---
-        run_command(["gcc", "-O0", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_O0")], "Building opt-variant (O0)")
-        run_command(["gcc", "-O3", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_O3")], "Building opt-variant (O3)")
-        run_command(["clang", "-O2", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_clang_O2")], "Building opt-variant (clang O2)")
-
-        # --- Stripped Variant ---
-        stripped_path = output_base_dir / f"{base_name}_stripped"
-        print(" - Building stripped...")
-        shutil.copy2(baseline_path, stripped_path)
-        run_command(["strip", str(stripped_path)], "Stripping binary")
-
-        # --- Tigress Variants ---
-        seed = str(int(time.time() * 1e9))
-
-        prepped_source_temp = None
-        try:
-            # Pre-process the source file for Tigress by adding required includes
-            print(" - Pre-processing source for Tigress...")
-            original_code = source_path.read_text()
-            prepped_code = "#include <stdlib.h>\n#include <time.h>\n" + original_code
-            prepped_source_temp = output_base_dir / f"{base_name}_prepped_temp.c"
-            prepped_source_temp.write_text(prepped_code)
-
-            # --- Control-Flow Flattening (CFF) ---
-            flat_source_temp = output_base_dir / f"{base_name}_flat_temp.c"
-            flat_binary = output_base_dir / f"{base_name}_cff"
-            cff_command = ["tigress", f"--Seed={seed}", "--Transform=Flatten", "--Functions=*", f"--out={flat_source_temp}", str(prepped_source_temp)]
-            run_command(cff_command, "Transforming with CFF")
-            run_command(["gcc", "-O2", "-pie", str(flat_source_temp), "-o", str(flat_binary)], "Building CFF binary")
-            os.remove(flat_source_temp)
-
-            # --- EncodeLiterals (with InitOpaque and InitEntropy) ---
-            elit_source_temp = output_base_dir / f"{base_name}_elit_temp.c"
-            elit_binary = output_base_dir / f"{base_name}_elit"
-            elit_command = [
-                "tigress", f"--Seed={seed}",
-                "--Transform=InitOpaque", "--Functions=main", "--InitOpaqueStructs=list,array",
-                "--Transform=InitEntropy",
-                "--Transform=EncodeLiterals", "--Functions=*",
-                f"--out={elit_source_temp}", str(prepped_source_temp)
-            ]
-            run_command(elit_command, "Transforming with InitOpaque+InitEntropy+EncodeLiterals")
-            run_command(["gcc", "-O2", "-pie", str(elit_source_temp), "-o", str(elit_binary)], "Building EncodeLiterals binary")
-            os.remove(elit_source_temp)
-        finally:
-            # Clean up the pre-processed temporary file
-            if prepped_source_temp and prepped_source_temp.exists():
-                os.remove(prepped_source_temp)
+    with SourceStore(SOURCE_STORE) as store:
+        for source_path in source_files_to_process:
+            print(f"\n[+] Processing Source File: {source_path}")
+            relative_path = source_path.relative_to(CORPUS_DIR)
+            output_base_dir = OUTPUT_DIR / relative_path.parent
+            base_name = source_path.stem
+            task, group = relative_path.parts[0], relative_path.parent.name
+            output_base_dir.mkdir(parents=True, exist_ok=True)
+
+            # --- Baseline Variant ---
+            baseline_path = output_base_dir / f"{base_name}_base"
+            run_command(["gcc", "-O2", "-pie", str(source_path), "-o", str(baseline_path)], "Building baseline")
+
+            # --- Debug Variant (same code as the baseline, plus DWARF for source_attribution.py) ---
+            run_command(["gcc", "-O2", "-g", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_g")], "Building debug variant (-g)")
+
+            # --- Optimization Variants ---
+            run_command(["gcc", "-O0", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_O0")], "Building opt-variant (O0)")
+            run_command(["gcc", "-O3", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_O3")], "Building opt-variant (O3)")
+            run_command(["clang", "-O2", "-pie", str(source_path), "-o", str(output_base_dir / f"{base_name}_clang_O2")], "Building opt-variant (clang O2)")
+
+            # --- Stripped Variant ---
+            stripped_path = output_base_dir / f"{base_name}_stripped"
+            print(" - Building stripped...")
+            shutil.copy2(baseline_path, stripped_path)
+            run_command(["strip", str(stripped_path)], "Stripping binary")
+
+            # --- Tigress Variants ---
+            seed = str(int(time.time() * 1e9))
+
+            prepped_source_temp = None
+            try:
+                # Pre-process the source file for Tigress by adding required includes
+                print(" - Pre-processing source for Tigress...")
+                original_code = source_path.read_text()
+                prepped_code = "#include <stdlib.h>\n#include <time.h>\n" + original_code
+                prepped_source_temp = output_base_dir / f"{base_name}_prepped_temp.c"
+                prepped_source_temp.write_text(prepped_code)
+
+                # --- Control-Flow Flattening (CFF) ---
+                flat_source_temp = output_base_dir / f"{base_name}_flat_temp.c"
+                flat_binary = output_base_dir / f"{base_name}_cff"
+                cff_command = ["tigress", f"--Seed={seed}", "--Transform=Flatten", "--Functions=*", f"--out={flat_source_temp}", str(prepped_source_temp)]
+                run_command(cff_command, "Transforming with CFF")
+                start = time.perf_counter()
+                run_command(["gcc", "-O2", "-pie", str(flat_source_temp), "-o", str(flat_binary)], "Building CFF binary")
+                store.record(flat_source_temp, task, group, base_name, "cff", seed, time.perf_counter() - start, flat_binary)
+                os.remove(flat_source_temp)
+
+                # --- EncodeLiterals (with InitOpaque and InitEntropy) ---
+                elit_source_temp = output_base_dir / f"{base_name}_elit_temp.c"
+                elit_binary = output_base_dir / f"{base_name}_elit"
+                elit_command = [
+                    "tigress", f"--Seed={seed}",
+                    "--Transform=InitOpaque", "--Functions=main", "--InitOpaqueStructs=list,array",
+                    "--Transform=InitEntropy",
+                    "--Transform=EncodeLiterals", "--Functions=*",
+                    f"--out={elit_source_temp}", str(prepped_source_temp)
+                ]
+                run_command(elit_command, "Transforming with InitOpaque+InitEntropy+EncodeLiterals")
+                start = time.perf_counter()
+                run_command(["gcc", "-O2", "-pie", str(elit_source_temp), "-o", str(elit_binary)], "Building EncodeLiterals binary")
+                store.record(elit_source_temp, task, group, base_name, "elit", seed, time.perf_counter() - start, elit_binary)
+                os.remove(elit_source_temp)
+            finally:
+                # Clean up the pre-processed temporary file
+                if prepped_source_temp and prepped_source_temp.exists():
+                    os.remove(prepped_source_temp)
 
     print("\n--- Build process completed successfully. ---")
 
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""
+Call graphs of the binaries and their Weisfeiler-Lehman subtree-kernel similarity.
+
+Nodes are the functions of a binary (cfg.function_ranges, so stripped
+binaries work too) plus one node per imported symbol. Edges come from direct
+calls, direct tail jumps to another function's entry, calls through a GOT
+slot and rip-relative lea of a function entry (callbacks); a call into a PLT
+stub becomes an edge to the import it binds. The graph is pruned to what main
+reaches, dropping the crt helpers every binary shares.
+
+Local functions all start with the same label, since their names differ
+between authors and disappear when stripped; imports are labelled by their
+symbol name. Every WL iteration relabels a node by hashing its label with the
+sorted labels of its callees and callers, so after h iterations a label
+describes the node's h-hop call neighbourhood. The labels of iterations
+0..h are hashed into 2**bits columns and counted, giving one sparse histogram
+per binary; the kernel of two binaries is the dot product of their
+histograms, and the similarity the cosine on the 0-100 scale of the other
+tools. Comparing a whole corpus is one sparse matrix product.
+"""
+import argparse
+import csv
+import hashlib
+import itertools
+import os
+import struct
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+import cfg
+import elf_utils
+import x86_decode as X
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+PAIRS_CSV = "callgraph_pairs.csv"
+WL_ITERATIONS = 3
+HASH_BITS = 20
+LOCAL_LABEL = "local"
+IMPORT_PREFIX = "import:"
+# Relocation sections binding GOT slots to dynamic symbols (.rela.dyn covers .plt.got)
+GOT_RELOCATIONS = (".rela.plt", ".rela.dyn")
+
+
+class CallGraph:
+    """Nodes are function entry addresses (ints) or import names (str)."""
+
+    def __init__(self):
+        self.names = {}
+        self.callees = {}
+        self.callers = {}
+
+    def add_node(self, node, name):
+        self.names.setdefault(node, name)
+        self.callees.setdefault(node, set())
+        self.callers.setdefault(node, set())
+
+    def add_edge(self, src, dst):
+        self.callees[src].add(dst)
+        self.callers[dst].add(src)
+
+    def subgraph(self, roots):
+        """The nodes reachable from roots; unchanged when roots is empty."""
+        if not roots:
+            return self
+        seen, stack = set(roots), list(roots)
+        while stack:
+            for callee in self.callees[stack.pop()]:
+                if callee not in seen:
+                    seen.add(callee)
+                    stack.append(callee)
+        sub = CallGraph()
+        for node in sorted(seen, key=str):
+            sub.add_node(node, self.names[node])
+        for node in seen:
+            for callee in self.callees[node]:
+                sub.add_edge(node, callee)
+        return sub
+
+    @property
+    def edges(self):
+        return [(src, dst) for src, dsts in self.callees.items() for dst in dsts]
+
+
+def got_slots(elf):
+    """{GOT slot address: dynamic symbol name} from the relocation sections."""
+    syms, name_of = elf.symbols(".dynsym")
+    slots = {}
+    for section in GOT_RELOCATIONS:
+        for rel in elf.relocations(section):
+            index = int(rel["info"]) >> 32
+            if 0 < index < len(syms):
+                name = name_of(syms[index]["name"])
+                if name:
+                    slots[int(rel["offset"])] = name
+    return slots
+
+
+def _slot(insn):
+    """GOT slot read by a `jmp/call [rip+disp]`, or None."""
+    if (insn.map == X.MAP_1BYTE and insn.opcode == 0xFF and insn.mod != 3
+            and insn.reg & 7 in (2, 4) and insn.rip_relative):
+        return insn.end + insn.disp
+    return None
+
+
+def plt_stubs(elf, slots):
+    """
+    {stub address: import name} for every PLT entry.
+
+    A stub is the `jmp [rip+slot]` of .plt/.plt.got/.plt.sec; with IBT the
+    endbr64 in front of it is where calls land, so both addresses are mapped.
+    """
+    stubs = {}
+    for section in elf.executable_sections():
+        if not section.name.startswith(".plt"):
+            continue
+        prev = None
+        for insn in X.sweep(elf.section_bytes(section), section.addr):
+            name = slots.get(_slot(insn)) if insn.reg & 7 == 4 else None
+            if name:
+                stubs.setdefault(insn.addr, name)
+                if prev is not None and prev.map == X.MAP_0F and prev.opcode == 0x1E and prev.end == insn.addr:
+                    stubs.setdefault(prev.addr, name)
+            prev = insn
+    return stubs
+
+
+def extract(path, prune=True):
+    """
+    Call graph of one binary.
+
+    With prune, only what the program itself reaches is kept: the functions
+    the entry stub hands to __libc_start_main (main) and everything they call
+    or take the address of. The crt helpers registered through .init_array and
+    .fini_array are identical in every binary and would otherwise dominate
+    small programs.
+    """
+    elf = elf_utils.ELFFile(path)
+    slots = got_slots(elf)
+    stubs = plt_stubs(elf, slots)
+    ranges = cfg.function_ranges(elf)
+    graph = CallGraph()
+    for start, _, name in ranges:
+        graph.add_node(start, name)
+    for start, size, _ in ranges:
+        for insn in cfg.decode_range(elf, start, size):
+            if insn.flow == X.FLOW_CALL or (insn.flow == X.FLOW_JMP and not start <= insn.target < start + size):
+                target = insn.target
+                if target in stubs:
+                    target = IMPORT_PREFIX + stubs[target]
+                elif target not in graph.names:
+                    continue
+            elif insn.flow in (X.FLOW_CALL_IND, X.FLOW_JMP_IND) and _slot(insn) in slots:
+                target = IMPORT_PREFIX + slots[_slot(insn)]
+            elif (insn.map == X.MAP_1BYTE and insn.opcode == 0x8D and insn.rip_relative
+                  and insn.end + insn.disp in graph.names and insn.end + insn.disp != start):
+                # Address taken: main handed to __libc_start_main, qsort comparators, ...
+                target = insn.end + insn.disp
+            else:
+                continue
+            if isinstance(target, str):
+                graph.add_node(target, target[len(IMPORT_PREFIX):])
+            graph.add_edge(start, target)
+    if prune and elf.entry in graph.names:
+        graph = graph.subgraph([n for n in graph.callees[elf.entry] if not isinstance(n, str)])
+    return graph
+
+
+def _hash(*parts):
+    digest = hashlib.blake2b(repr(parts).encode(), digest_size=8).digest()
+    return struct.unpack("<Q", digest)[0]
+
+
+def wl_labels(graph, iterations=WL_ITERATIONS):
+    """
+    Node labels of WL iterations 0..iterations.
+
+    Returns:
+        list: one {node: uint64 label} dict per iteration.
+    """
+    labels = {node: _hash(0, node if isinstance(node, str) else LOCAL_LABEL) for node in graph.names}
+    history = [labels]
+    for it in range(1, iterations + 1):
+        labels = {node: _hash(it, labels[node],
+                              tuple(sorted(labels[c] for c in graph.callees[node])),
+                              tuple(sorted(labels[c] for c in graph.callers[node])))
+                  for node in graph.names}
+        history.append(labels)
+    return history
+
+
+def wl_histogram(graph, iterations=WL_ITERATIONS, bits=HASH_BITS):
+    """
+    Hashed WL subtree feature counts of one graph.
+
+    Returns:
+        tuple: (columns int64 sorted, counts float64)
+    """
+    labels = np.array([label for level in wl_labels(graph, iterations) for label in level.values()],
+                      dtype=np.uint64)
+    columns, counts = np.unique(labels >> np.uint64(64 - bits), return_counts=True)
+    return columns.astype(np.int64), counts.astype(np.float64)
+
+
+def _histogram(args):
+    path, iterations, bits = args
+    try:
+        return path, *wl_histogram(extract(path), iterations, bits), None
+    except (ValueError, IndexError, OSError, struct.error) as e:
+        return path, np.empty(0, dtype=np.int64), np.empty(0), str(e)
+
+
+def feature_matrix(files, iterations=WL_ITERATIONS, bits=HASH_BITS, workers=None):
+    """
+    WL histograms of every file as rows of a CSR matrix, extracted in parallel.
+
+    Files that cannot be parsed get an empty row (similarity 0 to everything).
+
+    Returns:
+        tuple: (scipy.sparse.csr_matrix, {path: error})
+    """
+    from scipy import sparse
+
+    jobs = [(str(f), iterations, bits) for f in files]
+    if workers == 1:
+        rows = list(map(_histogram, jobs))
+    else:
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            rows = list(pool.map(_histogram, jobs, chunksize=4))
+    indptr, indices, data, errors = [0], [], [], {}
+    for path, columns, counts, error in rows:
+        if error:
+            errors[path] = error
+        indices.append(columns)
+        data.append(counts)
+        indptr.append(indptr[-1] + len(columns))
+    matrix = sparse.csr_matrix((np.concatenate(data) if data else np.empty(0),
+                                np.concatenate(indices) if indices else np.empty(0, dtype=np.int64),
+                                np.array(indptr)), shape=(len(jobs), 1 << bits))
+    return matrix, errors
+
+
+def similarity_matrix(matrix):
+    """All-pairs kernel normalized to cosine similarity, 0-100, as a dense array."""
+    kernel = (matrix @ matrix.T).toarray()
+    norms = np.sqrt(np.diag(kernel))
+    norms[norms == 0] = np.inf
+    return np.round(100 * kernel / np.outer(norms, norms), 2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Call-graph extraction and WL graph-kernel similarity")
+    parser.add_argument("files", nargs="*", type=Path,
+                        help="Binaries to compare (default: every binary under --output-dir)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--csv", default=PAIRS_CSV, help="All-pairs output when run over the corpus")
+    parser.add_argument("--iterations", type=int, default=WL_ITERATIONS)
+    parser.add_argument("--bits", type=int, default=HASH_BITS, help="log2 of the number of hash columns")
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    parser.add_argument("--edges", action="store_true", help="Print the call edges of each given file")
+    args = parser.parse_args()
+
+    if args.files:
+        if args.edges:
+            for f in args.files:
+                graph = extract(f)
+                print(f"{f}: {len(graph.names)} nodes, {len(graph.edges)} edges")
+                for src, dst in sorted(graph.edges, key=str):
+                    print(f"  {graph.names[src]} -> {graph.names[dst]}")
+        matrix, errors = feature_matrix(args.files, args.iterations, args.bits, args.workers)
+        for path, error in errors.items():
+            print(f" [Error] {path}: {error}")
+        scores = similarity_matrix(matrix)
+        for i, j in itertools.combinations(range(len(args.files)), 2):
+            print(f"{args.files[i].name} vs {args.files[j].name}: {scores[i, j]}")
+        return
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Extracting call graphs of {len(files)} binaries (WL h={args.iterations}, 2^{args.bits} columns)...")
+    start = time.perf_counter()
+    matrix, errors = feature_matrix(files, args.iterations, args.bits, args.workers)
+    scores = similarity_matrix(matrix)
+    elapsed = time.perf_counter() - start
+    for path, error in errors.items():
+        print(f" [Error] {path}: {error}")
+
+    names = [str(f.relative_to(args.output_dir)) for f in files]
+    with open(args.csv, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["File1", "File2", "Score"])
+        for i, j in zip(*np.triu_indices(len(files), k=1)):
+            writer.writerow([names[i], names[j], scores[i, j]])
+    print(f"Done in {elapsed:.2f}s: {matrix.nnz} stored labels, {len(files) * (len(files) - 1) // 2} pairs")
+    print(f"Pairs saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,710 @@
+#!/usr/bin/env python3
+"""
+Structural detector for Tigress control-flow flattening (Flatten transform).
+
+A flattened function is a dispatcher loop: a state variable is bounds-checked
+and used to index a switch table, and every original basic block becomes a
+case that stores the number of its successor in the state variable and jumps
+back to the dispatcher. cfg.build_cfg resolves the switch table; this pass
+
+  1. picks the table whose cases assign constant states and return to it,
+  2. runs a small value-set interpretation of every case (registers and
+     rsp/rbp stack slots hold sets of up to MAX_VALUES constants; mov/xor/
+     setcc/movzx/lea/add/sub/and/or/shifts/sbb/cmov are modelled, conditional
+     branches on the state refine it, anything else is unknown), and
+  3. reads the state sets reaching the table load as the edges of the
+     original block graph.
+
+Recovered nodes are the function entry, every case block reachable from it
+and one exit node that every case leaving the function (ret, tail call,
+noreturn call) points to, mirroring the shared epilogue of the original.
+cyclomatic uses the same E - N + 2 definition as cfg_metrics, but the
+recovered graph is the one Tigress flattened: source-level blocks, before gcc
+merged, if-converted or duplicated any of them in the _base build. On the
+corpus the recovered value equals the _base twin for only 37 of 148
+dispatchers, with differences from -9 to +5 (117 within +-2). It measures the
+structure behind the dispatcher, not the original function's metric; do not
+mix it into cfg_metrics comparisons as if it were the _base value.
+
+Run directly to scan every output/*/*/*_cff binary and its _base twin (which
+should show no dispatchers) and write cff_recovery.csv.
+"""
+import argparse
+import csv
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import cfg
+import elf_utils
+import x86_decode as X
+from cfg_metrics import describe_binary, function_metrics
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+MAX_VALUES = 16            # larger value sets become unknown
+MIN_CASES = 3              # distinct case blocks a dispatcher table needs
+MIN_RESOLVED_RATIO = 0.5   # share of returning cases that must send a constant state back
+MAX_BRANCH_STATES = 2      # successor cases of a block that looks like an original branch
+COLUMNS = ["task", "group", "binary", "function", "address", "dispatcher", "state_var", "cases",
+           "recovered_nodes", "recovered_edges", "recovered_cyclomatic", "exits", "unresolved",
+           "flattened_cyclomatic", "base_cyclomatic"]
+
+MASK64 = (1 << 64) - 1
+REG_NAMES = ["rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+             "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"]
+CALLER_SAVED = (0, 1, 2, 6, 7, 8, 9, 10, 11)
+ENTRY = "entry"
+EXIT = "exit"
+
+
+# --- Value-set interpretation ---
+
+def _mask(width):
+    return (1 << width) - 1
+
+
+def _signed(value, width):
+    value &= _mask(width)
+    return value - (1 << width) if value >> (width - 1) else value
+
+
+def _apply(values, fn):
+    """Map fn over a value set; None (unknown) stays unknown."""
+    if values is None:
+        return None
+    out = frozenset(fn(v) & MASK64 for v in values)
+    return out if len(out) <= MAX_VALUES else None
+
+
+def _apply2(a, b, fn):
+    if a is None or b is None or len(a) * len(b) > 4 * MAX_VALUES:
+        return None
+    out = frozenset(fn(x, y) & MASK64 for x in a for y in b)
+    return out if len(out) <= MAX_VALUES else None
+
+
+def _union(a, b):
+    if a is None or b is None:
+        return None
+    out = a | b
+    return out if len(out) <= MAX_VALUES else None
+
+
+def _condition(cc, value, imm, width):
+    """Outcome of jcc condition code cc after cmp value, imm at the given width."""
+    u, ui = value & _mask(width), imm & _mask(width)
+    s, si = _signed(value, width), _signed(imm, width)
+    # js/jns read SF of value - imm, which differs from s < si when the subtraction overflows
+    sign = _signed((value - imm) & _mask(width), width) < 0
+    return {
+        0x2: u < ui, 0x3: u >= ui, 0x4: u == ui, 0x5: u != ui,
+        0x6: u <= ui, 0x7: u > ui, 0x8: sign, 0x9: not sign,
+        0xC: s < si, 0xD: s >= si, 0xE: s <= si, 0xF: s > si,
+    }.get(cc)
+
+
+def _submasks(mask):
+    """Every value x & mask can take for an unknown x, when there are few."""
+    bits = [1 << i for i in range(64) if mask >> i & 1]
+    if 1 << len(bits) > MAX_VALUES:
+        return None
+    values = [0]
+    for bit in bits:
+        values += [v | bit for v in values]
+    return frozenset(values)
+
+
+class AbstractState:
+    """
+    Known value sets of registers (0-15) and stack slots (('s', base, disp)).
+
+    Missing keys are unknown. flags remembers the last cmp/test against a
+    constant as (key, imm, width) so conditional branches can split the set.
+    """
+    __slots__ = ("values", "flags")
+
+    def __init__(self, values=None, flags=None):
+        self.values = values or {}
+        self.flags = flags
+
+    def copy(self):
+        return AbstractState(dict(self.values), self.flags)
+
+    def get(self, key):
+        return self.values.get(key)
+
+    def set(self, key, values):
+        if values is None:
+            self.values.pop(key, None)
+        else:
+            self.values[key] = values
+        if self.flags and self.flags[0] == key:
+            self.flags = None
+
+    def join(self, other):
+        """Least upper bound; returns (state, changed)."""
+        values = {}
+        for key, mine in self.values.items():
+            merged = _union(mine, other.values.get(key))
+            if merged is not None:
+                values[key] = merged
+        flags = self.flags if self.flags == other.flags else None
+        changed = values != self.values or flags != self.flags
+        return AbstractState(values, flags), changed
+
+    def refine(self, cc, taken):
+        """State on one side of a conditional branch; None when that side is impossible."""
+        if self.flags is None:
+            return self
+        key, imm, width = self.flags
+        if _condition(cc, 0, imm, width) is None:
+            return self
+        values = self.values.get(key)
+        if values is None:
+            # An unsigned upper bound makes a small unknown value enumerable
+            bound = imm & _mask(width)
+            if cc not in (0x2, 0x3, 0x6, 0x7) or (cc in (0x2, 0x6)) != taken or bound >= MAX_VALUES:
+                return self
+            values = frozenset(range(bound + 1))
+        kept = frozenset(v for v in values if _condition(cc, v, imm, width) == taken)
+        if not kept:
+            return None
+        state = self.copy()
+        state.values[key] = kept
+        return state
+
+
+def _width(insn):
+    if insn.rex_w:
+        return 64
+    return 16 if 0x66 in insn.prefixes else 32
+
+
+def _slot(insn):
+    """Key of a stack slot operand ([rsp+d] / [rbp+d] without index)."""
+    if insn.mod != 3 and insn.index == -1 and insn.base in (X.REG_RSP, X.REG_RBP):
+        return ("s", insn.base, insn.disp)
+    return None
+
+
+def _operand(state, insn, memory=None, size=8):
+    """
+    Value set of the r/m operand.
+
+    Stack slots come from the state; other loads with known addresses are read
+    through memory(addr, size) (read-only data such as gcc's CSWTCH tables).
+    """
+    if insn.mod == 3:
+        return state.get(insn.rm)
+    slot = _slot(insn)
+    if slot:
+        return state.get(slot)
+    if memory is None:
+        return None
+    if insn.rip_relative:
+        base = frozenset([insn.end])
+    else:
+        base = state.get(insn.base) if insn.base >= 0 else frozenset([0])
+    index = state.get(insn.index) if insn.index >= 0 else frozenset([0])
+    addrs = _apply2(base, index, lambda b, i: b + i * insn.scale + insn.disp)
+    if addrs is None:
+        return None
+    values = [memory(a, size) for a in addrs]
+    return None if None in values else frozenset(values)
+
+
+def _write_rm(state, insn, values, width):
+    """Store to the r/m operand: 32-bit register writes zero-extend, 8/16-bit ones merge."""
+    if insn.mod == 3:
+        _write_reg(state, insn.rm, values, width)
+    else:
+        slot = _slot(insn)
+        if slot:
+            state.set(slot, _apply(values, lambda v: v & _mask(width)))
+        elif insn.base in (X.REG_RSP, X.REG_RBP):
+            # Indexed stack access: any slot may change
+            for key in [k for k in state.values if isinstance(k, tuple)]:
+                state.set(key, None)
+
+
+def _write_reg(state, reg, values, width):
+    if width >= 32:
+        state.set(reg, _apply(values, lambda v: v & _mask(width)))
+    else:
+        old = state.get(reg)
+        merged = _apply2(old, values, lambda o, v: (o & ~_mask(width)) | (v & _mask(width)))
+        if merged is None and old is None and width == 8:
+            # setcc / mov r8 into an unknown register: only the low byte is
+            # meaningful, which is what the following movzx reads
+            merged = _apply(values, lambda v: v & 0xFF)
+        state.set(reg, merged)
+
+
+def _clobber_reg_operands(state, insn):
+    """Forget every register operand of an unmodelled instruction."""
+    is_group = insn.key()[2] != -1    # ModRM.reg is an opcode extension, not a register
+    if insn.reg >= 0 and not is_group:
+        state.set(insn.reg, None)
+    if insn.mod == 3:
+        state.set(insn.rm, None)
+    elif insn.mod >= 0:
+        _write_rm(state, insn, None, 64)
+
+
+_ALU_IMM = {0: lambda a, b: a + b, 1: lambda a, b: a | b, 4: lambda a, b: a & b,
+            5: lambda a, b: a - b, 6: lambda a, b: a ^ b}
+_SHIFTS = {4: lambda v, n, w: v << n, 5: lambda v, n, w: (v & _mask(w)) >> n,
+           7: lambda v, n, w: _signed(v, w) >> n}
+_ALU_RM = {0x01: 0, 0x03: 0, 0x09: 1, 0x0B: 1, 0x21: 4, 0x23: 4, 0x29: 5, 0x2B: 5, 0x31: 6, 0x33: 6}
+_ALU_EAX = {0x05: 0, 0x0D: 1, 0x25: 4, 0x2D: 5, 0x35: 6}
+# Instructions that write no register; the compares among them replace the flags
+_COMPARE_1BYTE = frozenset([0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x84, 0x85, 0xA8, 0xA9])
+_READ_ONLY_1BYTE = _COMPARE_1BYTE | frozenset([0x90, 0xC3, 0xCC, 0xF4, 0xE9, 0xEB] + list(range(0x50, 0x58))
+                                              + list(range(0x70, 0x80)))
+
+
+def step(state, insn, memory=None):
+    """Apply one instruction to state in place; memory(addr, size) reads constant data."""
+    m, op = insn.map, insn.opcode
+    width = _width(insn)
+    flags = state.flags
+    keep_flags = False
+
+    if insn.flow in (X.FLOW_CALL, X.FLOW_CALL_IND):
+        for reg in CALLER_SAVED:
+            state.set(reg, None)
+        state.flags = None
+        return
+    if m == X.MAP_1BYTE:
+        if 0xB8 <= op <= 0xBF:                                   # mov r, imm
+            _write_reg(state, (op & 7) | (8 if insn.rex & 1 else 0), frozenset([insn.imm & MASK64]), width)
+            keep_flags = True
+        elif 0xB0 <= op <= 0xB7:                                 # mov r8, imm8
+            _write_reg(state, (op & 7) | (8 if insn.rex & 1 else 0), frozenset([insn.imm & 0xFF]), 8)
+            keep_flags = True
+        elif op in (0xC6, 0xC7) and insn.reg & 7 == 0:           # mov r/m, imm
+            _write_rm(state, insn, frozenset([insn.imm & MASK64]), 8 if op == 0xC6 else width)
+            keep_flags = True
+        elif op in (0x88, 0x89):                                 # mov r/m, r
+            _write_rm(state, insn, state.get(insn.reg), 8 if op == 0x88 else width)
+            keep_flags = True
+        elif op in (0x8A, 0x8B):                                 # mov r, r/m
+            size = 1 if op == 0x8A else width // 8
+            _write_reg(state, insn.reg, _operand(state, insn, memory, size), size * 8)
+            keep_flags = True
+        elif op == 0x8D:                                         # lea
+            if insn.rip_relative:
+                value = frozenset([(insn.end + insn.disp) & MASK64])
+            else:
+                base = state.get(insn.base) if insn.base >= 0 else frozenset([0])
+                if insn.index == insn.base:
+                    # lea r, [x + x*k + c]: one register, not two independent sets
+                    value = _apply(base, lambda b: b * (insn.scale + 1) + insn.disp)
+                else:
+                    index = state.get(insn.index) if insn.index >= 0 else frozenset([0])
+                    value = _apply2(base, index, lambda b, i: b + i * insn.scale + insn.disp)
+            _write_reg(state, insn.reg, value, width)
+            keep_flags = True
+        elif op == 0x63:                                         # movsxd
+            source = _operand(state, insn, memory, 4)
+            _write_reg(state, insn.reg, _apply(source, lambda v: _signed(v, 32)), width)
+            keep_flags = True
+        elif op in (0x80, 0x81, 0x83) and insn.reg & 7 == 7:    # cmp r/m, imm
+            key = insn.rm if insn.mod == 3 else _slot(insn)
+            state.flags = (key, insn.imm, 8 if op == 0x80 else width) if key is not None else None
+            return
+        elif op in (0x3C, 0x3D):
+            state.flags = (0, insn.imm, 8 if op == 0x3C else width)
+            return
+        elif op in (0x84, 0x85) and insn.mod == 3 and insn.reg == insn.rm:   # test r, r
+            state.flags = (insn.rm, 0, 8 if op == 0x84 else width)
+            return
+        elif op in (0x81, 0x83) and insn.reg & 7 in _ALU_IMM:    # alu r/m, imm
+            fn = _ALU_IMM[insn.reg & 7]
+            source = _operand(state, insn)
+            if source is None and insn.reg & 7 == 4:
+                source = _submasks(insn.imm & _mask(width))
+            _write_rm(state, insn, _apply(source, lambda v: fn(v, insn.imm)), width)
+        elif op in _ALU_EAX:
+            fn = _ALU_IMM[_ALU_EAX[op]]
+            source = state.get(0)
+            if source is None and op == 0x25:
+                source = _submasks(insn.imm & _mask(width))
+            _write_reg(state, 0, _apply(source, lambda v: fn(v, insn.imm)), width)
+        elif op in _ALU_RM and insn.mod == 3:                    # alu r, r
+            fn = _ALU_IMM[_ALU_RM[op]]
+            if op in (0x31, 0x33, 0x29, 0x2B) and insn.reg == insn.rm:
+                value = frozenset([0])
+            else:
+                dst, src = (insn.rm, insn.reg) if op & 2 == 0 else (insn.reg, insn.rm)
+                value = _apply2(state.get(dst), state.get(src), fn)
+            _write_reg(state, insn.rm if op & 2 == 0 else insn.reg, value, width)
+        elif op in (0x19, 0x1B) and insn.mod == 3 and insn.reg == insn.rm:  # sbb r, r
+            _write_reg(state, insn.reg, frozenset([0, MASK64]), width)
+        elif op in (0x81, 0x83) and insn.reg & 7 in (2, 3):     # adc / sbb r/m, imm: carry unknown
+            sign = 1 if insn.reg & 7 == 2 else -1
+            _write_rm(state, insn, _apply2(_operand(state, insn), frozenset([0, 1]),
+                                           lambda v, c: v + sign * (insn.imm + c)), width)
+        elif op in (0xC1, 0xD1) and insn.reg & 7 in _SHIFTS:    # shl / shr / sar
+            count = (insn.imm if op == 0xC1 else 1) & (63 if width == 64 else 31)
+            fn = _SHIFTS[insn.reg & 7]
+            source = _operand(state, insn)
+            if source is None and count == width - 1 and insn.reg & 7 != 4:
+                # Sign extraction (sar x, 63 / shr x, 31) of an unknown value
+                source = frozenset([0, MASK64])
+            _write_rm(state, insn, _apply(source, lambda v: fn(v, count, width)), width)
+        elif op == 0xF7 and insn.reg & 7 in (2, 3):              # not / neg
+            fn = (lambda v: ~v) if insn.reg & 7 == 2 else (lambda v: -v)
+            _write_rm(state, insn, _apply(_operand(state, insn), fn), width)
+        elif op in (0xFF, 0xFE) and insn.reg & 7 in (0, 1):     # inc / dec
+            delta = 1 if insn.reg & 7 == 0 else -1
+            _write_rm(state, insn, _apply(_operand(state, insn), lambda v: v + delta), width)
+        elif op in _READ_ONLY_1BYTE or (op == 0xFF and insn.reg & 7 == 6):
+            keep_flags = op not in _COMPARE_1BYTE
+        elif 0x58 <= op <= 0x5F:                                 # pop
+            state.set((op & 7) | (8 if insn.rex & 1 else 0), None)
+            keep_flags = True
+        elif op == 0x98:                                         # cdqe / cwde
+            _write_reg(state, 0, _apply(state.get(0), lambda v: _signed(v, width // 2)), width)
+        elif op == 0x99:                                         # cqo / cdq
+            state.set(2, None)
+        elif op in (0xF6, 0xF7) and insn.reg & 7 >= 4:          # mul / div family
+            state.set(0, None)
+            state.set(2, None)
+        elif op == 0xC9:                                         # leave
+            state.set(X.REG_RBP, None)
+        elif 0xA4 <= op <= 0xAF:                                 # string ops
+            for reg in (0, 1, 6, 7):
+                state.set(reg, None)
+        elif insn.modrm >= 0:
+            # Direction bit of the classic two-operand ALU block selects the destination
+            if op < 0x40 and insn.mod != 3 and op & 2 == 0:
+                _write_rm(state, insn, None, 64)
+            else:
+                _clobber_reg_operands(state, insn)
+    elif m == X.MAP_0F:
+        if 0x90 <= op <= 0x9F and insn.mod == 3:                 # setcc r8
+            _write_reg(state, insn.rm, frozenset([0, 1]), 8)
+            keep_flags = True
+        elif op in (0xB6, 0xB7):                                 # movzx
+            source = _operand(state, insn, memory, 1 if op == 0xB6 else 2)
+            _write_reg(state, insn.reg, _apply(source, lambda v: v & (0xFF if op == 0xB6 else 0xFFFF)), width)
+            keep_flags = True
+        elif op in (0xBE, 0xBF):                                 # movsx
+            bits = 8 if op == 0xBE else 16
+            _write_reg(state, insn.reg, _apply(_operand(state, insn), lambda v: _signed(v, bits)), width)
+            keep_flags = True
+        elif 0x40 <= op <= 0x4F:                                 # cmovcc: either value
+            _write_reg(state, insn.reg, _union(state.get(insn.reg), _operand(state, insn)), width)
+            keep_flags = True
+        elif op == 0x1F or op == 0x1E or 0x80 <= op <= 0x8F:     # nop / endbr / jcc
+            keep_flags = True
+        elif op in (0xA2, 0x31, 0x05):                           # cpuid / rdtsc / syscall
+            for reg in (0, 1, 2, 3, 11):
+                state.set(reg, None)
+        elif insn.modrm >= 0:
+            _clobber_reg_operands(state, insn)
+    elif insn.modrm >= 0:
+        _clobber_reg_operands(state, insn)
+
+    if keep_flags:
+        if state.flags is None and flags is not None and flags[0] in state.values:
+            state.flags = flags
+    else:
+        state.flags = None
+
+
+# --- Dispatcher recovery ---
+
+class Walk:
+    """Result of interpreting the code from one block up to the dispatcher."""
+    __slots__ = ("states", "unresolved", "exits", "at_load")
+
+    def __init__(self):
+        self.states = set()
+        self.unresolved = False
+        self.exits = False
+        self.at_load = None
+
+
+def walk(func, table, start, initial, through=False, memory=None):
+    """
+    Fixpoint interpretation from block start.
+
+    By default paths stop at the table load and the Walk holds the state
+    values that reach it, whether an unknown state reached it and whether
+    some path leaves the function. With through=True the dispatcher is
+    followed into its cases (each with the state narrowed to its case numbers)
+    and at_load is the join of every state seen at the load.
+    """
+    result = Walk()
+    cases = table.cases()
+    states_in = {start: initial}
+    worklist = [start]
+    budget = 64 * max(len(func.blocks), 1)
+
+    def propagate(succ, succ_state):
+        if succ not in states_in:
+            states_in[succ] = succ_state
+            worklist.append(succ)
+        else:
+            merged, changed = states_in[succ].join(succ_state)
+            if changed:
+                states_in[succ] = merged
+                worklist.append(succ)
+
+    while worklist and budget:
+        budget -= 1
+        addr = worklist.pop()
+        state = states_in[addr].copy()
+        block = func.blocks[addr]
+        stopped = False
+        for insn in block.insns:
+            if insn.addr == table.load:
+                values = state.get(table.index)
+                if values is None:
+                    result.unresolved = True
+                else:
+                    result.states.update(values)
+                if not through:
+                    stopped = True
+                    break
+                result.at_load = state.copy() if result.at_load is None else result.at_load.join(state)[0]
+            step(state, insn, memory)
+        if stopped:
+            continue
+
+        last = block.last
+        if last.addr == table.jump and through:
+            known = state.get(table.index)
+            for target, numbers in cases.items():
+                numbers = frozenset(numbers)
+                if known is not None:
+                    numbers &= known
+                if numbers and target in func.blocks:
+                    case_state = state.copy()
+                    case_state.set(table.index, numbers)
+                    propagate(target, case_state)
+            continue
+        if last.flow in (X.FLOW_RET, X.FLOW_STOP, X.FLOW_BAD) or not block.succs:
+            result.exits = True
+            continue
+        if last.flow == X.FLOW_JMP and not func.contains(last.target):
+            result.exits = True
+            continue
+        for succ in block.succs:
+            succ_state = state
+            if last.flow == X.FLOW_JCC:
+                succ_state = state.refine(last.opcode & 0xF, succ == last.target)
+                if succ_state is None:
+                    continue
+            propagate(succ, succ_state)
+    if worklist:
+        result.unresolved = True
+    return result
+
+
+class Flattening:
+    """Recovered original control flow of one flattened function."""
+
+    def __init__(self, table, cases, graph, exits, unresolved):
+        self.table = table
+        self.cases = cases              # {case block: [state numbers]}
+        self.graph = graph              # {node: set(successor nodes)}; nodes are ENTRY, EXIT or case blocks
+        self.exits = exits              # case nodes with a path leaving the function
+        self.unresolved = unresolved    # nodes whose next state could not be determined
+
+    @property
+    def state_var(self):
+        return REG_NAMES[self.table.index]
+
+    @property
+    def nodes(self):
+        return len(self.graph)
+
+    @property
+    def edges(self):
+        return sum(len(succs) for succs in self.graph.values())
+
+    @property
+    def cyclomatic(self):
+        return self.edges - self.nodes + 2 if self.graph else 0
+
+
+def _successors(table, states):
+    """Case blocks selected by a set of state values (out-of-range values are dropped)."""
+    blocks = set()
+    for value in states:
+        if value < len(table.targets) and table.targets[value] is not None:
+            blocks.add(table.targets[value])
+    return blocks
+
+
+def constant_reader(elf):
+    """memory(addr, size) callback for walk(): little-endian loads from read-only sections."""
+    def read(addr, size):
+        section = elf.section_at(addr)
+        if section is None or section.flags & elf_utils.SHF_WRITE:
+            return None
+        raw = elf.read(addr, size)
+        return int.from_bytes(raw, "little") if raw is not None else None
+    return read
+
+
+def recover(func, elf=None):
+    """
+    Flattening of a function built by cfg.build_cfg, or None when it has no dispatcher.
+
+    With elf, loads from read-only data (switch lookup tables gcc builds inside
+    cases) are evaluated.
+    Every switch table is tried; the dispatcher is the one whose cases mostly
+    feed back a constant state selecting one or two cases, like the jump or
+    two-way branch that ended the original block. A switch in a loop over input
+    sends every case back to every case instead and is rejected. Each case starts from the state that
+    holds at the table load on every iteration (found by interpreting the
+    whole function), so loop-invariant registers such as state constants
+    parked in callee-saved registers stay known.
+    """
+    memory = constant_reader(elf) if elf is not None else None
+    best = None
+    for table in func.jump_tables.values():
+        cases = table.cases()
+        if len(cases) < MIN_CASES:
+            continue
+        invariant = walk(func, table, func.start, AbstractState(), True, memory).at_load or AbstractState()
+        invariant.flags = None
+        walks = {}
+        for target, numbers in cases.items():
+            if target in func.blocks:
+                initial = invariant.copy()
+                initial.set(table.index, frozenset(numbers))
+                walks[target] = walk(func, table, target, initial, memory=memory)
+        resolved = sum(1 for w in walks.values()
+                       if w.states and not w.unresolved
+                       and len(_successors(table, w.states)) <= MAX_BRANCH_STATES)
+        unknown = sum(1 for w in walks.values() if w.unresolved)
+        if resolved < 2 or resolved < MIN_RESOLVED_RATIO * (resolved + unknown):
+            continue
+        if best is None or resolved > best[0]:
+            best = (resolved, table, cases, walks)
+    if best is None:
+        return None
+
+    _, table, cases, walks = best
+    walks[ENTRY] = walk(func, table, func.start, AbstractState(), memory=memory)
+    graph, exits, unresolved = {}, set(), set()
+    pending = [ENTRY]
+    while pending:
+        node = pending.pop()
+        if node in graph:
+            continue
+        result = walks[node]
+        graph[node] = _successors(table, result.states)
+        if result.exits:
+            exits.add(node)
+            graph[node].add(EXIT)
+        if result.unresolved:
+            unresolved.add(node)
+        pending.extend(s for s in graph[node] if s in walks and s not in graph)
+    if exits:
+        graph[EXIT] = set()
+    return Flattening(table, cases, graph, exits, unresolved)
+
+
+# --- Driver ---
+
+def analyze_binary(path, output_dir=OUTPUT_DIR, twin_suffix="_base"):
+    """One row per function of a binary that has a dispatcher."""
+    path = Path(path)
+    elf = elf_utils.ELFFile(path)
+    info = describe_binary(path, output_dir)
+    program = path.name.split("_", 1)[0]
+    twin = path.with_name(program + twin_suffix)
+    twin_metrics = {}
+    if twin.is_file() and twin != path:
+        twin_elf = elf_utils.ELFFile(twin)
+        for start, size, name in cfg.function_ranges(twin_elf):
+            twin_metrics[name] = function_metrics(cfg.build_cfg(twin_elf, start, size, name))["cyclomatic"]
+
+    rows = []
+    for start, size, name in cfg.function_ranges(elf):
+        func = cfg.build_cfg(elf, start, size, name)
+        flat = recover(func, elf)
+        if flat is None:
+            continue
+        rows.append({
+            "task": info["task"],
+            "group": info["group"],
+            "binary": info["binary"],
+            "function": name,
+            "address": hex(start),
+            "dispatcher": hex(flat.table.jump),
+            "state_var": flat.state_var,
+            "cases": len(flat.cases),
+            "recovered_nodes": flat.nodes,
+            "recovered_edges": flat.edges,
+            "recovered_cyclomatic": flat.cyclomatic,
+            "exits": len(flat.exits),
+            "unresolved": len(flat.unresolved),
+            "flattened_cyclomatic": function_metrics(func)["cyclomatic"],
+            "base_cyclomatic": twin_metrics.get(name, ""),
+        })
+    return rows
+
+
+def _analyze(args):
+    path, output_dir = args
+    try:
+        return path, analyze_binary(path, output_dir), None
+    except (ValueError, IndexError, OSError) as e:
+        return path, [], str(e)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Detect Tigress flattening and recover the original CFG")
+    parser.add_argument("files", nargs="*", type=Path, help="Binaries (default: output/*/*/*_cff)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    parser.add_argument("--csv", default="cff_recovery.csv")
+    args = parser.parse_args()
+
+    files = args.files or sorted(args.output_dir.glob("*/*/*_cff"))
+    controls = [] if args.files else sorted(args.output_dir.glob("*/*/*_base"))
+    start = time.perf_counter()
+    rows, flagged_controls = [], 0
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        jobs = [(str(f), args.output_dir) for f in files + controls]
+        for path, file_rows, error in pool.map(_analyze, jobs, chunksize=4):
+            if error:
+                print(f" [Error] {path}: {error}")
+            if path.endswith("_base"):
+                flagged_controls += len(file_rows)
+                for row in file_rows:
+                    print(f" [Warning] dispatcher reported in control {path}:{row['function']}")
+            else:
+                rows.extend(file_rows)
+    elapsed = time.perf_counter() - start
+
+    flattened = {(row["task"], row["group"], row["binary"]) for row in rows}
+    deltas = [row["recovered_cyclomatic"] - row["base_cyclomatic"] for row in rows
+              if isinstance(row["base_cyclomatic"], int)]
+    print(f"Binaries: {len(files)} flattened, {len(controls)} controls, {elapsed:.2f}s")
+    print(f"Dispatchers: {len(rows)} functions in {len(flattened)} binaries; {flagged_controls} in controls")
+    print(f"Functions fully resolved: {sum(1 for r in rows if not r['unresolved'])}/{len(rows)}")
+    if deltas:
+        near = sum(1 for d in deltas if abs(d) <= 2)
+        print(f"Recovered cyclomatic equals _base twin: {deltas.count(0)}/{len(deltas)} "
+              f"(within +-2: {near}, range {min(deltas):+d}..{max(deltas):+d}); "
+              f"the recovered graph is Tigress's, not the original function's")
+
+    with open(args.csv, "w", newline="") as csvfile:
+        writer = csv.DictWriter(csvfile, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Results saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,324 @@
+"""
+Basic-block and control-flow-graph recovery on top of x86_decode.
+
+Functions come from the symbol table (start, size, name), or from .eh_frame
+and code-reference scanning (func_recovery) when the binary is stripped.
+Blocks start at the function entry, at every intra-function branch target and
+after every instruction that ends a block (jumps, returns, hlt/ud2). Calls do not end a
+block, matching Ghidra's simple block model. Edges are fall-through and direct
+branch targets inside the function; direct jumps leaving the function are tail
+calls and produce no edge. Register-indirect jumps through a compiler switch
+table (lea base; movsxd off,[base+idx*4]; add off,base; jmp off) are resolved
+and contribute one edge per distinct case target.
+"""
+import struct
+
+import func_recovery
+import x86_decode as X
+
+# Flow classes that end a basic block
+_BLOCK_END = frozenset([X.FLOW_JMP, X.FLOW_JCC, X.FLOW_RET, X.FLOW_JMP_IND, X.FLOW_STOP, X.FLOW_BAD])
+# Flow classes that never continue at the next instruction
+_NO_FALLTHROUGH = frozenset([X.FLOW_JMP, X.FLOW_RET, X.FLOW_JMP_IND, X.FLOW_STOP, X.FLOW_BAD])
+# Entries read from a jump table whose bound is not checked in front of it
+MAX_TABLE_ENTRIES = 1024
+# How far back from a register jump the table idiom is searched
+TABLE_SCAN_INSNS = 12
+
+
+class Block:
+    __slots__ = ("start", "insns", "succs", "preds")
+
+    def __init__(self, start):
+        self.start = start
+        self.insns = []
+        self.succs = []
+        self.preds = []
+
+    @property
+    def end(self):
+        return self.insns[-1].end if self.insns else self.start
+
+    @property
+    def last(self):
+        return self.insns[-1]
+
+
+class JumpTable:
+    """
+    One resolved switch jump.
+
+    jump is the address of the register jmp, load the movsxd that reads the
+    table, index the register holding the case number and targets[i] the
+    destination of case i (None when it points outside the function).
+    """
+    __slots__ = ("jump", "load", "index", "table", "bound_check", "targets")
+
+    def __init__(self, jump, load, index, table, bound_check, targets):
+        self.jump = jump
+        self.load = load
+        self.index = index
+        self.table = table
+        self.bound_check = bound_check
+        self.targets = targets
+
+    def cases(self):
+        """{target: [case numbers]} for the targets inside the function."""
+        by_target = {}
+        for case, target in enumerate(self.targets):
+            if target is not None:
+                by_target.setdefault(target, []).append(case)
+        return by_target
+
+
+class Function:
+    """Blocks of one function keyed by start address, plus the edge list."""
+
+    def __init__(self, name, start, size):
+        self.name = name
+        self.start = start
+        self.size = size
+        self.blocks = {}
+        self.edges = []
+        self.insns = []
+        self.jump_tables = {}
+
+    def contains(self, addr):
+        return self.start <= addr < self.start + self.size
+
+    def add_edge(self, src, dst):
+        """Add src -> dst once; both are block start addresses."""
+        if dst in self.blocks[src].succs:
+            return
+        self.blocks[src].succs.append(dst)
+        self.blocks[dst].preds.append(src)
+        self.edges.append((src, dst))
+
+
+def function_ranges(elf):
+    """
+    (start, size, name) of every function symbol in an executable section.
+
+    Symbols without a size (hand-written crt stubs) extend to the next function
+    or the end of their section. Stripped binaries use recovered boundaries.
+    """
+    funcs = elf.functions()
+    if not funcs:
+        return func_recovery.recover_functions(elf)
+    exec_sections = elf.executable_sections()
+    ranges = []
+    for i, (start, size, name) in enumerate(funcs):
+        section = next((s for s in exec_sections if s.contains(start)), None)
+        if section is None:
+            continue
+        if not size:
+            limit = section.addr + section.size
+            if i + 1 < len(funcs) and funcs[i + 1][0] < limit:
+                limit = funcs[i + 1][0]
+            size = limit - start
+        ranges.append((start, size, name))
+    return ranges
+
+
+def decode_range(elf, start, size):
+    """Linear-sweep decode of [start, start+size) from the section holding it."""
+    section = elf.section_at(start)
+    code = elf.section_bytes(section)
+    begin = start - section.addr
+    return list(X.sweep(code, section.addr, begin, min(begin + size, len(code))))
+
+
+def _is_cmp_imm(insn, reg):
+    """cmp reg, imm (any operand size)."""
+    if insn.map != X.MAP_1BYTE:
+        return False
+    if insn.opcode in (0x80, 0x81, 0x83):
+        return insn.mod == 3 and insn.reg & 7 == 7 and insn.rm == reg
+    return insn.opcode in (0x3C, 0x3D) and reg == 0
+
+
+def resolve_jump_table(elf, func, i):
+    """
+    Resolve the register jmp at func.insns[i] as a switch table, or None.
+
+    The table base comes from the closest preceding rip-relative lea of the
+    base register; the case count from a preceding cmp idx, imm guarding the
+    load with ja/jae. Without a bound, entries are read while they point inside
+    the function.
+    """
+    insns = func.insns
+    jump = insns[i]
+    if jump.map != X.MAP_1BYTE or jump.opcode != 0xFF or jump.mod != 3:
+        return None
+    target_reg = jump.rm
+    lo = max(0, i - TABLE_SCAN_INSNS)
+
+    base_reg = load = None
+    for k in range(i - 1, lo - 1, -1):
+        insn = insns[k]
+        if insn.map != X.MAP_1BYTE or insn.mod != 3 or not insn.rex_w:
+            continue
+        if insn.opcode == 0x01 and insn.rm == target_reg:
+            base_reg = insn.reg
+        elif insn.opcode == 0x03 and insn.reg == target_reg:
+            base_reg = insn.rm
+        else:
+            continue
+        for j in range(k - 1, lo - 1, -1):
+            cand = insns[j]
+            if (cand.map == X.MAP_1BYTE and cand.opcode == 0x63 and cand.reg == target_reg
+                    and cand.mod != 3 and cand.base == base_reg and cand.scale == 4 and cand.index >= 0):
+                load = j
+                break
+        break
+    if load is None:
+        return None
+    index_reg = insns[load].index
+
+    table = None
+    for k in range(load - 1, -1, -1):
+        insn = insns[k]
+        if insn.map == X.MAP_1BYTE and insn.opcode == 0x8D and insn.reg == base_reg and insn.rip_relative:
+            table = insn.end + insn.disp
+            break
+    if table is None:
+        return None
+
+    count = bound_check = None
+    for k in range(load - 1, max(-1, load - 1 - TABLE_SCAN_INSNS), -1):
+        insn = insns[k]
+        if not _is_cmp_imm(insn, index_reg):
+            continue
+        for branch in insns[k + 1:load]:
+            if branch.flow == X.FLOW_JCC:
+                cc = branch.opcode & 0xF
+                if cc in (0x7, 0x6):
+                    count = insn.imm + 1
+                elif cc in (0x3, 0x2):
+                    count = insn.imm
+                break
+        if count is not None:
+            bound_check = insn.addr
+        break
+    if count is not None and not 0 < count <= MAX_TABLE_ENTRIES:
+        count = None
+
+    targets = []
+    for case in range(count if count is not None else MAX_TABLE_ENTRIES):
+        raw = elf.read(table + 4 * case, 4)
+        if raw is None:
+            break
+        target = table + struct.unpack("<i", raw)[0]
+        if not func.contains(target):
+            if count is None:
+                break
+            target = None
+        targets.append(target)
+    if not any(t is not None for t in targets):
+        return None
+    return JumpTable(jump.addr, insns[load].addr, index_reg, table, bound_check, targets)
+
+
+def build_cfg(elf, start, size, name="", insns=None):
+    """Recover the basic blocks and intra-function edges of one function."""
+    func = Function(name, start, size)
+    func.insns = insns if insns is not None else decode_range(elf, start, size)
+    if not func.insns:
+        return func
+
+    leaders = {start}
+    for i, insn in enumerate(func.insns):
+        if insn.flow in (X.FLOW_JMP, X.FLOW_JCC) and func.contains(insn.target):
+            leaders.add(insn.target)
+        elif insn.flow == X.FLOW_JMP_IND:
+            jt = resolve_jump_table(elf, func, i)
+            if jt is not None:
+                func.jump_tables[insn.addr] = jt
+                leaders.update(t for t in jt.targets if t is not None)
+        if insn.flow in _BLOCK_END and i + 1 < len(func.insns):
+            leaders.add(func.insns[i + 1].addr)
+
+    block = None
+    for insn in func.insns:
+        if insn.addr in leaders or block is None:
+            block = func.blocks.setdefault(insn.addr, Block(insn.addr))
+        block.insns.append(insn)
+
+    for addr, block in func.blocks.items():
+        last = block.last
+        if last.flow in (X.FLOW_JMP, X.FLOW_JCC) and last.target in func.blocks:
+            func.add_edge(addr, last.target)
+        elif last.addr in func.jump_tables:
+            for target in func.jump_tables[last.addr].cases():
+                if target in func.blocks:
+                    func.add_edge(addr, target)
+        if last.flow not in _NO_FALLTHROUGH and last.end in func.blocks:
+            func.add_edge(addr, last.end)
+    return func
+
+
+def reverse_postorder(func):
+    """Blocks reachable from the entry, in reverse postorder."""
+    seen = set()
+    order = []
+    stack = [(func.start, iter(func.blocks[func.start].succs))] if func.blocks else []
+    if stack:
+        seen.add(func.start)
+    while stack:
+        node, succs = stack[-1]
+        for succ in succs:
+            if succ not in seen:
+                seen.add(succ)
+                stack.append((succ, iter(func.blocks[succ].succs)))
+                break
+        else:
+            order.append(node)
+            stack.pop()
+    return order[::-1]
+
+
+def dominators(func):
+    """Immediate dominator of every reachable block (Cooper-Harvey-Kennedy)."""
+    order = reverse_postorder(func)
+    index = {b: i for i, b in enumerate(order)}
+    idom = {func.start: func.start} if order else {}
+
+    def intersect(a, b):
+        while a != b:
+            while index[a] > index[b]:
+                a = idom[a]
+            while index[b] > index[a]:
+                b = idom[b]
+        return a
+
+    changed = True
+    while changed:
+        changed = False
+        for node in order[1:]:
+            preds = [p for p in func.blocks[node].preds if p in idom]
+            if not preds:
+                continue
+            new = preds[0]
+            for p in preds[1:]:
+                new = intersect(p, new)
+            if idom.get(node) != new:
+                idom[node] = new
+                changed = True
+    return idom
+
+
+def dominates(idom, a, b):
+    """True when block a dominates block b."""
+    while True:
+        if a == b:
+            return True
+        parent = idom.get(b)
+        if parent is None or parent == b:
+            return False
+        b = parent
+
+
+def back_edges(func, idom=None):
+    """Edges whose target dominates their source: the latches of natural loops."""
+    idom = dominators(func) if idom is None else idom
+    return [(src, dst) for src, dst in func.edges if src in idom and dominates(idom, dst, src)]
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Native per-function CFG metrics for every binary in output/.
+
+Produces the structural columns of ghidra_statistics.csv without running
+Ghidra: ELF parsing, x86-64 decoding and basic-block/CFG recovery are done in
+process (elf_utils, x86_decode, cfg) and binaries are spread over worker
+processes. Column definitions:
+
+  nodes        basic blocks in the function body
+  edges        intra-function CFG edges
+  cyclomatic   edges - nodes + 2 (Ghidra's definition)
+  while        natural loops (distinct headers of back edges)
+  if           conditional branches that are not loop latches
+  goto         forward unconditional jumps inside the function
+  locals       distinct stack slots addressed through rbp (negative offsets) or rsp
+  insn_count   decoded instructions
+  code_len     function size in bytes
+
+decompiled_len needs a decompiler and is not reproduced; code_len is the
+closest native size measure. Functions of stripped binaries are recovered from
+.eh_frame and named sub_<addr>. With --cache, results are kept in the
+analysis cache keyed by binary hash and only new or changed binaries are
+decoded again.
+"""
+import argparse
+import csv
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import analysis_cache
+import cfg
+import elf_utils
+import func_recovery
+import x86_decode as X
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+# Cache key of function_rows(). The version hashes the source of every module it
+# runs, so code changes invalidate the cache by themselves; bump the base only when
+# the output changes for another reason (e.g. a dependency outside these files)
+ANALYZER = "native-cfg"
+ANALYZER_VERSION = analysis_cache.source_version(
+    "2", [__file__, cfg.__file__, func_recovery.__file__, elf_utils.__file__, X.__file__])
+DEFENSE_NAMES = {
+    "_base": "Base",
+    "_O0": "O0",
+    "_O3": "O3",
+    "_clang_O2": "Clang_O2",
+    "_cff": "CFF",
+    "_elit": "ELIT",
+    "_stripped": "Stripped",
+    "_g": "Debug",
+}
+COLUMNS = ["task", "group", "basename", "binary", "origin", "defense", "function", "address",
+           "cyclomatic", "nodes", "edges", "locals", "if", "goto", "while", "insn_count", "code_len"]
+
+
+def stack_slots(insns):
+    """Distinct frame-pointer / stack-pointer relative memory slots."""
+    slots = set()
+    for insn in insns:
+        if not insn.has_memory_operand or insn.index != -1:
+            continue
+        if insn.base == X.REG_RBP and insn.disp < 0:
+            slots.add(("rbp", insn.disp))
+        elif insn.base == X.REG_RSP and insn.disp >= 0:
+            slots.add(("rsp", insn.disp))
+    return len(slots)
+
+
+def function_metrics(func):
+    """Structural metrics of one recovered function."""
+    idom = cfg.dominators(func)
+    latches = cfg.back_edges(func, idom)
+    latch_sources = {src for src, _ in latches}
+    n_nodes = len(func.blocks)
+    n_edges = len(func.edges)
+    ifs = gotos = 0
+    for addr, block in func.blocks.items():
+        last = block.last
+        if last.flow == X.FLOW_JCC and addr not in latch_sources:
+            ifs += 1
+        elif last.flow == X.FLOW_JMP and func.contains(last.target) and last.target > last.addr:
+            gotos += 1
+    return {
+        "cyclomatic": n_edges - n_nodes + 2 if n_nodes else 0,
+        "nodes": n_nodes,
+        "edges": n_edges,
+        "locals": stack_slots(func.insns),
+        "if": ifs,
+        "goto": gotos,
+        "while": len({dst for _, dst in latches}),
+        "insn_count": len(func.insns),
+        "code_len": func.size,
+    }
+
+
+def describe_binary(path, output_dir):
+    """task / group / origin / defense columns derived from output/<task>/<group>/<N><suffix>."""
+    path = Path(path)
+    try:
+        task, group, _ = path.relative_to(output_dir).parts
+    except ValueError:
+        task, group = "", ""
+    name = path.name
+    program = name.split("_", 1)[0]
+    suffix = name[len(program):]
+    return {
+        "task": task,
+        "group": group,
+        "basename": name,
+        "binary": name,
+        "origin": "Human" if group == "human" else "LLM",
+        "defense": DEFENSE_NAMES.get(suffix, suffix.lstrip("_")),
+    }
+
+
+def function_rows(path):
+    """Metric rows for every function of one binary; depends only on the file contents."""
+    elf = elf_utils.ELFFile(path)
+    rows = []
+    for start, size, name in cfg.function_ranges(elf):
+        func = cfg.build_cfg(elf, start, size, name)
+        rows.append({"function": name, "address": hex(start), **function_metrics(func)})
+    return rows
+
+
+def analyze_binary(path, output_dir=OUTPUT_DIR):
+    """Metric rows for every function of one binary, with its path-derived columns."""
+    info = describe_binary(path, output_dir)
+    return [{**info, **row} for row in function_rows(path)]
+
+
+def _analyze(args):
+    path, output_dir = args
+    try:
+        return path, analyze_binary(path, output_dir), None
+    except (ValueError, IndexError, OSError) as e:
+        return path, [], str(e)
+
+
+def analyze_tree(files, output_dir=OUTPUT_DIR, workers=None):
+    """Analyze many binaries in parallel; returns (rows, {path: error})."""
+    rows, errors = [], {}
+    jobs = [(str(f), output_dir) for f in files]
+    with ProcessPoolExecutor(max_workers=workers) as pool:
+        for path, file_rows, error in pool.map(_analyze, jobs, chunksize=8):
+            rows.extend(file_rows)
+            if error:
+                errors[path] = error
+    return rows, errors
+
+
+def analyze_tree_cached(files, cache_path, output_dir=OUTPUT_DIR, workers=None):
+    """analyze_tree through the analysis cache: only new or changed binaries are decoded."""
+    with analysis_cache.AnalysisCache(cache_path) as cache:
+        results, errors, hits = analysis_cache.cached_analysis(
+            files, ANALYZER, ANALYZER_VERSION, function_rows, cache, workers)
+    print(f"Cache: {hits} hits, {len(files) - hits} analysed")
+    rows = []
+    for path in map(str, files):
+        info = describe_binary(path, output_dir)
+        rows.extend({**info, **row} for row in results.get(path, []))
+    return rows, errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Native CFG metrics for every function in output/")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    parser.add_argument("--csv", default="native_cfg_statistics.csv")
+    parser.add_argument("--cache", type=Path, help="Analysis cache file to reuse and update")
+    args = parser.parse_args()
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Analyzing {len(files)} binaries with {args.workers} workers...")
+    start = time.perf_counter()
+    if args.cache:
+        rows, errors = analyze_tree_cached(files, args.cache, args.output_dir, args.workers)
+    else:
+        rows, errors = analyze_tree(files, args.output_dir, args.workers)
+    elapsed = time.perf_counter() - start
+    for path, error in errors.items():
+        print(f" [Error] {path}: {error}")
+    print(f"Done: {len(rows)} functions in {elapsed:.2f}s")
+
+    with open(args.csv, "w", newline="") as csvfile:
+        writer = csv.DictWriter(csvfile, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Results saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,528 @@
+"""
+Streaming reader for the parts of DWARF 2-5 that map code back to source.
+
+  - .debug_line: the line-number programs are run unit by unit and their rows
+    collected into a LineTable, which answers address -> (file, line)
+  - .debug_info/.debug_abbrev: compile units are walked DIE by DIE, and the
+    subprograms with code (low_pc/high_pc or DW_AT_ranges through
+    .debug_rnglists / .debug_ranges) are returned with their names, following
+    DW_AT_abstract_origin / DW_AT_specification for out-of-line copies
+
+Only what gcc and clang emit for ordinary executables is handled; split DWARF
+(.dwo), type units and the indexed forms that need .debug_addr/.debug_str_offsets
+are skipped instead of being decoded. Each DWARF section is copied out of the
+file once and parsed one unit at a time.
+"""
+import bisect
+import struct
+
+# Forms
+DW_FORM_addr = 0x01
+DW_FORM_block2 = 0x03
+DW_FORM_block4 = 0x04
+DW_FORM_data2 = 0x05
+DW_FORM_data4 = 0x06
+DW_FORM_data8 = 0x07
+DW_FORM_string = 0x08
+DW_FORM_block = 0x09
+DW_FORM_block1 = 0x0A
+DW_FORM_data1 = 0x0B
+DW_FORM_flag = 0x0C
+DW_FORM_sdata = 0x0D
+DW_FORM_strp = 0x0E
+DW_FORM_udata = 0x0F
+DW_FORM_ref_addr = 0x10
+DW_FORM_ref1 = 0x11
+DW_FORM_ref2 = 0x12
+DW_FORM_ref4 = 0x13
+DW_FORM_ref8 = 0x14
+DW_FORM_ref_udata = 0x15
+DW_FORM_indirect = 0x16
+DW_FORM_sec_offset = 0x17
+DW_FORM_exprloc = 0x18
+DW_FORM_flag_present = 0x19
+DW_FORM_strx = 0x1A
+DW_FORM_addrx = 0x1B
+DW_FORM_ref_sup4 = 0x1C
+DW_FORM_strp_sup = 0x1D
+DW_FORM_data16 = 0x1E
+DW_FORM_line_strp = 0x1F
+DW_FORM_ref_sig8 = 0x20
+DW_FORM_implicit_const = 0x21
+DW_FORM_loclistx = 0x22
+DW_FORM_rnglistx = 0x23
+DW_FORM_ref_sup8 = 0x24
+DW_FORM_strx1, DW_FORM_strx2, DW_FORM_strx3, DW_FORM_strx4 = 0x25, 0x26, 0x27, 0x28
+DW_FORM_addrx1, DW_FORM_addrx2, DW_FORM_addrx3, DW_FORM_addrx4 = 0x29, 0x2A, 0x2B, 0x2C
+# Tags and attributes
+DW_TAG_compile_unit = 0x11
+DW_TAG_partial_unit = 0x3C
+DW_TAG_subprogram = 0x2E
+DW_AT_name = 0x03
+DW_AT_low_pc = 0x11
+DW_AT_high_pc = 0x12
+DW_AT_comp_dir = 0x1B
+DW_AT_abstract_origin = 0x31
+DW_AT_decl_line = 0x3B
+DW_AT_specification = 0x47
+DW_AT_ranges = 0x55
+DW_AT_linkage_name = 0x6E
+# Unit types (DWARF 5)
+DW_UT_compile = 0x01
+DW_UT_partial = 0x03
+# Line-number program
+DW_LNS_copy = 0x01
+DW_LNS_advance_pc = 0x02
+DW_LNS_advance_line = 0x03
+DW_LNS_set_file = 0x04
+DW_LNS_const_add_pc = 0x08
+DW_LNS_fixed_advance_pc = 0x09
+DW_LNE_end_sequence = 0x01
+DW_LNE_set_address = 0x02
+DW_LNCT_path = 0x1
+DW_LNCT_directory_index = 0x2
+# Range lists (DWARF 5)
+DW_RLE_end_of_list = 0x00
+DW_RLE_base_addressx = 0x01
+DW_RLE_startx_endx = 0x02
+DW_RLE_startx_length = 0x03
+DW_RLE_offset_pair = 0x04
+DW_RLE_base_address = 0x05
+DW_RLE_start_end = 0x06
+DW_RLE_start_length = 0x07
+
+_FIXED_SIZE = {
+    DW_FORM_data1: 1, DW_FORM_ref1: 1, DW_FORM_flag: 1, DW_FORM_strx1: 1, DW_FORM_addrx1: 1,
+    DW_FORM_data2: 2, DW_FORM_ref2: 2, DW_FORM_strx2: 2, DW_FORM_addrx2: 2,
+    DW_FORM_strx3: 3, DW_FORM_addrx3: 3,
+    DW_FORM_data4: 4, DW_FORM_ref4: 4, DW_FORM_ref_sup4: 4, DW_FORM_strx4: 4, DW_FORM_addrx4: 4,
+    DW_FORM_data8: 8, DW_FORM_ref8: 8, DW_FORM_ref_sig8: 8, DW_FORM_ref_sup8: 8,
+    DW_FORM_data16: 16,
+}
+_REFS = frozenset([DW_FORM_ref1, DW_FORM_ref2, DW_FORM_ref4, DW_FORM_ref8, DW_FORM_ref_udata])
+
+
+class _Reader:
+    """Cursor over a section's bytes."""
+
+    def __init__(self, data, pos=0):
+        self.data = data
+        self.pos = pos
+
+    def u(self, size):
+        value = int.from_bytes(self.data[self.pos:self.pos + size], "little")
+        self.pos += size
+        return value
+
+    def s8(self):
+        value = struct.unpack_from("<b", self.data, self.pos)[0]
+        self.pos += 1
+        return value
+
+    def uleb(self):
+        result = shift = 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            result |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return result
+
+    def sleb(self):
+        result = shift = 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            result |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return result - (1 << shift) if byte & 0x40 else result
+
+    def cstr(self):
+        end = self.data.find(b"\0", self.pos)
+        if end < 0:
+            end = len(self.data)
+        value, self.pos = self.data[self.pos:end], end + 1
+        return value.decode("utf-8", "replace")
+
+    def initial_length(self):
+        """Unit length and offset size (4 for 32-bit DWARF, 8 for 64-bit)."""
+        length = self.u(4)
+        if length == 0xFFFFFFFF:
+            return self.u(8), 8
+        return length, 4
+
+
+def _cstring_at(data, offset):
+    if data is None or offset >= len(data):
+        return ""
+    return _Reader(data, offset).cstr()
+
+
+class _Sections:
+    """The DWARF sections of one file as bytes objects (absent ones are None)."""
+
+    def __init__(self, elf):
+        def get(name):
+            s = elf.section(name)
+            return bytes(elf.section_bytes(s)) if s is not None and s.size else None
+        self.info = get(".debug_info")
+        self.abbrev = get(".debug_abbrev")
+        self.line = get(".debug_line")
+        self.str = get(".debug_str")
+        self.line_str = get(".debug_line_str")
+        self.rnglists = get(".debug_rnglists")
+        self.ranges = get(".debug_ranges")
+
+
+def _form_value(r, form, unit, implicit=None):
+    """Value of one attribute: int, str, bytes, or None for forms that are skipped."""
+    if form == DW_FORM_indirect:
+        return _form_value(r, r.uleb(), unit)
+    if form == DW_FORM_implicit_const:
+        return implicit
+    if form == DW_FORM_flag_present:
+        return 1
+    if form in _FIXED_SIZE:
+        value = r.u(_FIXED_SIZE[form])
+        return unit["offset"] + value if form in _REFS else value
+    if form == DW_FORM_addr:
+        return r.u(unit["address_size"])
+    if form in (DW_FORM_udata, DW_FORM_strx, DW_FORM_addrx, DW_FORM_loclistx, DW_FORM_rnglistx):
+        return r.uleb()
+    if form == DW_FORM_ref_udata:
+        return unit["offset"] + r.uleb()
+    if form == DW_FORM_sdata:
+        return r.sleb()
+    if form == DW_FORM_string:
+        return r.cstr()
+    if form in (DW_FORM_strp, DW_FORM_line_strp, DW_FORM_strp_sup):
+        offset = r.u(unit["offset_size"])
+        sections = unit["sections"]
+        return _cstring_at(sections.line_str if form == DW_FORM_line_strp else sections.str, offset)
+    if form in (DW_FORM_sec_offset, DW_FORM_ref_addr):
+        size = unit["offset_size"] if form == DW_FORM_sec_offset or unit["version"] >= 3 else unit["address_size"]
+        return r.u(size)
+    if form in (DW_FORM_block1, DW_FORM_block2, DW_FORM_block4, DW_FORM_block, DW_FORM_exprloc):
+        size = {DW_FORM_block1: 1, DW_FORM_block2: 2, DW_FORM_block4: 4}.get(form)
+        length = r.u(size) if size else r.uleb()
+        value = r.data[r.pos:r.pos + length]
+        r.pos += length
+        return value
+    raise ValueError(f"unsupported DWARF form {form:#x}")
+
+
+# --- .debug_line ---
+
+def _entry_formats(r):
+    return [(r.uleb(), r.uleb()) for _ in range(r.u(1))]
+
+
+def _line_header_v5(r, unit):
+    """Directory and file names of a DWARF 5 line-program header."""
+    directories = []
+    fmt = _entry_formats(r)
+    for _ in range(r.uleb()):
+        entry = {ct: _form_value(r, form, unit) for ct, form in fmt}
+        directories.append(entry.get(DW_LNCT_path, ""))
+    files = []
+    fmt = _entry_formats(r)
+    for _ in range(r.uleb()):
+        entry = {ct: _form_value(r, form, unit) for ct, form in fmt}
+        files.append((entry.get(DW_LNCT_path, ""), entry.get(DW_LNCT_directory_index, 0)))
+    return directories, files
+
+
+def _line_header_legacy(r, comp_dir):
+    """Directory and file names of a DWARF 2-4 header, re-indexed like DWARF 5 (0 = compilation)."""
+    directories = [comp_dir]
+    while True:
+        name = r.cstr()
+        if not name:
+            break
+        directories.append(name)
+    files = [("", 0)]
+    while True:
+        name = r.cstr()
+        if not name:
+            break
+        directory = r.uleb()
+        r.uleb()
+        r.uleb()
+        files.append((name, directory))
+    return directories, files
+
+
+def _join(directory, name):
+    if not name or name.startswith("/") or not directory:
+        return name
+    return directory.rstrip("/") + "/" + name
+
+
+def line_rows(sections):
+    """
+    Yield (address, file, line, end_sequence) for every row of every line program.
+
+    file is the path as recorded by the compiler (directory joined to name).
+    """
+    data = sections.line
+    if data is None:
+        return
+    pos = 0
+    while pos < len(data):
+        r = _Reader(data, pos)
+        length, offset_size = r.initial_length()
+        end = r.pos + length
+        pos = end
+        version = r.u(2)
+        unit = {"offset": 0, "offset_size": offset_size, "version": version, "address_size": 8,
+                "sections": sections}
+        if version >= 5:
+            unit["address_size"] = r.u(1)
+            r.u(1)
+        header_length = r.u(offset_size)
+        program = r.pos + header_length
+        min_inst = r.u(1)
+        if version >= 4:
+            r.u(1)      # maximum_operations_per_instruction: always 1 outside VLIW targets
+        r.u(1)          # default_is_stmt
+        line_base = r.s8()
+        line_range = r.u(1)
+        opcode_base = r.u(1)
+        std_lengths = [r.u(1) for _ in range(opcode_base - 1)]
+        if version >= 5:
+            directories, files = _line_header_v5(r, unit)
+        else:
+            directories, files = _line_header_legacy(r, "")
+        paths = [_join(directories[d] if d < len(directories) else "", name) for name, d in files]
+
+        def path_of(index):
+            return paths[index] if 0 <= index < len(paths) else ""
+
+        r.pos = program
+        address, file_index, line = 0, 1, 1
+        while r.pos < end:
+            opcode = r.u(1)
+            if opcode >= opcode_base:
+                adjusted = opcode - opcode_base
+                address += (adjusted // line_range) * min_inst
+                line += line_base + adjusted % line_range
+                yield address, path_of(file_index), line, False
+            elif opcode == 0:
+                size = r.uleb()
+                after = r.pos + size
+                sub = r.u(1)
+                if sub == DW_LNE_end_sequence:
+                    yield address, path_of(file_index), line, True
+                    address, file_index, line = 0, 1, 1
+                elif sub == DW_LNE_set_address:
+                    address = r.u(size - 1)
+                r.pos = after
+            elif opcode == DW_LNS_copy:
+                yield address, path_of(file_index), line, False
+            elif opcode == DW_LNS_advance_pc:
+                address += r.uleb() * min_inst
+            elif opcode == DW_LNS_advance_line:
+                line += r.sleb()
+            elif opcode == DW_LNS_set_file:
+                file_index = r.uleb()
+            elif opcode == DW_LNS_const_add_pc:
+                address += ((255 - opcode_base) // line_range) * min_inst
+            elif opcode == DW_LNS_fixed_advance_pc:
+                address += r.u(2)
+            else:
+                for _ in range(std_lengths[opcode - 1]):
+                    r.uleb()
+
+
+class LineTable:
+    """address -> (file, line) lookup built from the rows of every sequence."""
+
+    def __init__(self, rows):
+        # The last row at an address wins; end_sequence rows map to None
+        table = {}
+        for address, path, line, end in rows:
+            table[address] = None if end else (path, line)
+        self.addresses = sorted(table)
+        self.entries = [table[a] for a in self.addresses]
+
+    def __len__(self):
+        return len(self.addresses)
+
+    def lookup(self, address):
+        """(file, line) of the row covering address, or None."""
+        i = bisect.bisect_right(self.addresses, address) - 1
+        return self.entries[i] if i >= 0 else None
+
+
+# --- .debug_info ---
+
+def _abbreviations(data, offset):
+    """{code: (tag, has_children, [(attribute, form, implicit const)])} of one abbreviation table."""
+    r = _Reader(data, offset)
+    table = {}
+    while True:
+        code = r.uleb()
+        if code == 0:
+            return table
+        tag = r.uleb()
+        children = r.u(1)
+        attrs = []
+        while True:
+            attr, form = r.uleb(), r.uleb()
+            if attr == 0 and form == 0:
+                break
+            attrs.append((attr, form, r.sleb() if form == DW_FORM_implicit_const else None))
+        table[code] = (tag, bool(children), attrs)
+
+
+def _rnglist(sections, offset, base, version, address_size):
+    """[(lo, hi)] of one range list."""
+    ranges = []
+    if version >= 5:
+        if sections.rnglists is None:
+            return ranges
+        r = _Reader(sections.rnglists, offset)
+        while r.pos < len(r.data):
+            kind = r.u(1)
+            if kind == DW_RLE_end_of_list:
+                break
+            if kind == DW_RLE_offset_pair:
+                lo, hi = r.uleb(), r.uleb()
+                ranges.append((base + lo, base + hi))
+            elif kind == DW_RLE_base_address:
+                base = r.u(address_size)
+            elif kind == DW_RLE_start_end:
+                ranges.append((r.u(address_size), r.u(address_size)))
+            elif kind == DW_RLE_start_length:
+                lo = r.u(address_size)
+                ranges.append((lo, lo + r.uleb()))
+            elif kind in (DW_RLE_base_addressx,):
+                r.uleb()
+            elif kind in (DW_RLE_startx_endx, DW_RLE_startx_length):
+                r.uleb()
+                r.uleb()
+            else:
+                break
+        return ranges
+    if sections.ranges is None:
+        return ranges
+    r = _Reader(sections.ranges, offset)
+    top = (1 << (8 * address_size)) - 1
+    while r.pos + 2 * address_size <= len(r.data):
+        lo, hi = r.u(address_size), r.u(address_size)
+        if lo == 0 and hi == 0:
+            break
+        if lo == top:
+            base = hi
+        else:
+            ranges.append((base + lo, base + hi))
+    return ranges
+
+
+class Subprogram:
+    __slots__ = ("name", "ranges", "decl_line")
+
+    def __init__(self, name, ranges, decl_line):
+        self.name = name
+        self.ranges = ranges
+        self.decl_line = decl_line
+
+
+def subprograms(sections):
+    """Every subprogram DIE with code, in .debug_info order."""
+    data = sections.info
+    if data is None or sections.abbrev is None:
+        return []
+    names = {}
+    decl_lines = {}
+    origins = {}
+    found = []      # (ranges, decl_line, own name, origin offset)
+    pos = 0
+    while pos < len(data):
+        r = _Reader(data, pos)
+        unit_offset = pos
+        length, offset_size = r.initial_length()
+        end = r.pos + length
+        pos = end
+        version = r.u(2)
+        if version >= 5:
+            unit_type = r.u(1)
+            address_size = r.u(1)
+            abbrev_offset = r.u(offset_size)
+            if unit_type not in (DW_UT_compile, DW_UT_partial):
+                continue
+        else:
+            abbrev_offset = r.u(offset_size)
+            address_size = r.u(1)
+        unit = {"offset": unit_offset, "offset_size": offset_size, "version": version,
+                "address_size": address_size, "sections": sections}
+        abbrevs = _abbreviations(sections.abbrev, abbrev_offset)
+        base = 0
+        while r.pos < end:
+            die_offset = r.pos
+            code = r.uleb()
+            if code == 0:
+                continue
+            tag, _, attrs = abbrevs[code]
+            values = {}
+            for attr, form, implicit in attrs:
+                values[attr] = (_form_value(r, form, unit, implicit), form)
+            name = values.get(DW_AT_name, (None,))[0]
+            if isinstance(name, str):
+                names[die_offset] = name
+            decl = values.get(DW_AT_decl_line, (None,))[0]
+            if isinstance(decl, int):
+                decl_lines[die_offset] = decl
+            origin = values.get(DW_AT_abstract_origin) or values.get(DW_AT_specification)
+            if origin is not None:
+                origins[die_offset] = origin[0]
+            if tag in (DW_TAG_compile_unit, DW_TAG_partial_unit):
+                low = values.get(DW_AT_low_pc)
+                base = low[0] if low and isinstance(low[0], int) and low[1] == DW_FORM_addr else 0
+                continue
+            if tag != DW_TAG_subprogram:
+                continue
+            ranges = []
+            low, high = values.get(DW_AT_low_pc), values.get(DW_AT_high_pc)
+            if low is not None and high is not None and low[1] == DW_FORM_addr:
+                hi = high[0] if high[1] == DW_FORM_addr else low[0] + high[0]
+                ranges.append((low[0], hi))
+            elif DW_AT_ranges in values and values[DW_AT_ranges][1] == DW_FORM_sec_offset:
+                ranges = _rnglist(sections, values[DW_AT_ranges][0], base, version, address_size)
+            if not ranges:
+                continue
+            found.append((ranges, decl_lines.get(die_offset, 0), name, origins.get(die_offset)))
+
+    result = []
+    for ranges, decl_line, name, origin in found:
+        # Follow origin chains (concrete copy -> abstract instance -> declaration)
+        seen = set()
+        while (not name or not decl_line) and origin is not None and origin not in seen:
+            seen.add(origin)
+            name = name or names.get(origin)
+            decl_line = decl_line or decl_lines.get(origin, 0)
+            origin = origins.get(origin)
+        result.append(Subprogram(name or "", ranges, decl_line))
+    return result
+
+
+class DebugInfo:
+    """Line table and subprogram ranges of one ELF file."""
+
+    def __init__(self, elf):
+        sections = _Sections(elf)
+        self.has_dwarf = sections.line is not None
+        self.lines = LineTable(line_rows(sections))
+        self.functions = subprograms(sections)
+        spans = sorted((lo, hi, f.name) for f in self.functions for lo, hi in f.ranges if hi > lo)
+        self._starts = [lo for lo, _, _ in spans]
+        self._spans = spans
+
+    def function_at(self, address):
+        """Name of the subprogram whose ranges cover address, or ""."""
+        i = bisect.bisect_right(self._starts, address) - 1
+        if i >= 0 and address < self._spans[i][1]:
+            return self._spans[i][2]
+        return ""
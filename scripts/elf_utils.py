@@ -0,0 +1,133 @@
+"""
+Minimal zero-dependency ELF64 little-endian reader for the corpus binaries.
+
+Only what the native analysis passes need: section headers, symbol tables and
+reads by virtual address. The file is kept as one bytes object and sections are
+handed out as memoryview slices, so nothing is copied while parsing.
+"""
+import struct
+from pathlib import Path
+
+import numpy as np
+
+# Section types
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHT_DYNSYM = 11
+# Section flags
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+# Symbol types
+STT_FUNC = 2
+# x86-64 relocation types
+R_X86_64_JUMP_SLOT = 7
+R_X86_64_RELATIVE = 8
+
+SYM_DTYPE = np.dtype([
+    ("name", "<u4"), ("info", "u1"), ("other", "u1"), ("shndx", "<u2"), ("value", "<u8"), ("size", "<u8"),
+])
+RELA_DTYPE = np.dtype([("offset", "<u8"), ("info", "<u8"), ("addend", "<i8")])
+
+
+class Section:
+    __slots__ = ("name", "type", "flags", "addr", "offset", "size", "link", "info", "entsize")
+
+    def __init__(self, name, type_, flags, addr, offset, size, link, info, entsize):
+        self.name = name
+        self.type = type_
+        self.flags = flags
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+        self.info = info
+        self.entsize = entsize
+
+    def contains(self, addr):
+        return self.addr <= addr < self.addr + self.size
+
+
+class ELFFile:
+    """Parsed section table of one ELF64 file."""
+
+    def __init__(self, path):
+        self.path = Path(path)
+        self.data = self.path.read_bytes()
+        self.view = memoryview(self.data)
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 2 or self.data[5] != 1:
+            raise ValueError(f"{self.path} is not a little-endian ELF64 file")
+        (self.type, self.machine, _, self.entry, _, shoff, _, _, _, _,
+         shentsize, shnum, shstrndx) = struct.unpack_from("<HHIQQQIHHHHHH", self.data, 16)
+
+        raw = [struct.unpack_from("<IIQQQQIIQQ", self.data, shoff + i * shentsize) for i in range(shnum)]
+        strtab = raw[shstrndx] if shnum else None
+        self.sections = []
+        for name_off, type_, flags, addr, offset, size, link, info, _, entsize in raw:
+            name = self._cstring(strtab[4] + name_off) if strtab else ""
+            self.sections.append(Section(name, type_, flags, addr, offset, size, link, info, entsize))
+        self.by_name = {s.name: s for s in self.sections}
+
+    def _cstring(self, offset):
+        """NUL-terminated name at offset; empty when it runs off the end of a damaged file."""
+        end = self.data.find(b"\0", offset)
+        if end < 0:
+            return ""
+        return self.data[offset:end].decode("utf-8", "replace")
+
+    def section(self, name):
+        return self.by_name.get(name)
+
+    def section_bytes(self, section):
+        """memoryview of a section's file contents (empty for .bss-like sections)."""
+        if isinstance(section, str):
+            section = self.by_name.get(section)
+        if section is None or section.type == SHT_NOBITS:
+            return memoryview(b"")
+        return self.view[section.offset:section.offset + section.size]
+
+    def section_at(self, addr):
+        for s in self.sections:
+            if s.addr and s.type != SHT_NOBITS and s.contains(addr):
+                return s
+        return None
+
+    def read(self, addr, size):
+        """Bytes at a virtual address, or None when it is not backed by the file."""
+        s = self.section_at(addr)
+        if s is None or addr + size > s.addr + s.size:
+            return None
+        start = s.offset + addr - s.addr
+        return self.data[start:start + size]
+
+    def symbols(self, table=".symtab"):
+        """Structured array view of a symbol table plus a name lookup function."""
+        s = self.by_name.get(table)
+        if s is None:
+            return np.empty(0, dtype=SYM_DTYPE), lambda _: ""
+        syms = np.frombuffer(self.data, dtype=SYM_DTYPE, count=s.size // SYM_DTYPE.itemsize, offset=s.offset)
+        strtab = self.sections[s.link]
+        return syms, lambda off: self._cstring(strtab.offset + int(off))
+
+    def relocations(self, name):
+        """Structured array view of a RELA section (empty when absent)."""
+        s = self.by_name.get(name)
+        if s is None:
+            return np.empty(0, dtype=RELA_DTYPE)
+        return np.frombuffer(self.data, dtype=RELA_DTYPE, count=s.size // RELA_DTYPE.itemsize, offset=s.offset)
+
+    def functions(self):
+        """
+        Defined function symbols from .symtab.
+
+        Returns:
+            list: (start, size, name) sorted by address; empty when stripped.
+        """
+        syms, name_of = self.symbols(".symtab")
+        funcs = {}
+        for sym in syms[((syms["info"] & 0xF) == STT_FUNC) & (syms["shndx"] != 0) & (syms["value"] != 0)]:
+            funcs.setdefault(int(sym["value"]), (int(sym["value"]), int(sym["size"]), name_of(sym["name"])))
+        return sorted(funcs.values())
+
+    def executable_sections(self):
+        return [s for s in self.sections if s.flags & SHF_EXECINSTR and s.type != SHT_NOBITS]
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+SHA-1 hashing of overlapping 64-byte features, as done by sdhash-style digests.
+
+Two kernels are provided:
+  - "scalar":      one hashlib.sha1 call per feature. hashlib is OpenSSL, which
+                   already switches to the SHA-NI instructions when the CPU has
+                   them, so on such machines this is the SHA-NI path.
+  - "multibuffer": all features are hashed together as independent lanes of
+                   uint32 numpy arrays, i.e. every SHA-1 round is one vector
+                   operation over thousands of features. A 64-byte feature is
+                   exactly one message block; the second (padding) block is the
+                   same for every lane, so its message schedule is precomputed.
+
+select_kernel() picks one at runtime. Even with SHA-NI the scalar path is bound
+by per-call overhead, so the lane kernel wins once a batch holds a couple of
+thousand features (a single corpus binary has ~16k); small batches go to the
+scalar path. FEATURE_HASH_KERNEL overrides the choice. Run this file directly
+to benchmark features/s of each kernel on the corpus.
+"""
+import argparse
+import hashlib
+import os
+import time
+from pathlib import Path
+
+import numpy as np
+
+# --- Configuration ---
+FEATURE_SIZE = 64
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+KERNELS = ("scalar", "multibuffer")
+# Below this batch size the fixed cost of 160 vector rounds outweighs the lanes
+MIN_MULTIBUFFER_LANES = 2048
+
+_K = (0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6)
+_H0 = (0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0)
+
+
+def _rotl(x, n):
+    return (x << np.uint32(n)) | (x >> np.uint32(32 - n))
+
+
+def _schedule(words):
+    """Expand 16 message words (scalars or lane arrays) to the 80-word schedule."""
+    w = list(words)
+    for t in range(16, 80):
+        x = w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16]
+        w.append(((x << 1) | (x >> 31)) & 0xFFFFFFFF if isinstance(x, int) else _rotl(x, 1))
+    return w
+
+
+def _padding_schedule(message_len):
+    """Schedule of the final block for a message that exactly fills whole blocks."""
+    words = [0x80000000] + [0] * 13 + [(message_len * 8) >> 32, (message_len * 8) & 0xFFFFFFFF]
+    return [np.uint32(v) for v in _schedule(words)]
+
+
+_PAD64 = _padding_schedule(FEATURE_SIZE)
+
+
+def _compress(state, w):
+    """One SHA-1 compression over all lanes; w is the 80-word schedule."""
+    a, b, c, d, e = state
+    for t in range(80):
+        if t < 20:
+            f = d ^ (b & (c ^ d))
+        elif t < 40:
+            f = b ^ c ^ d
+        elif t < 60:
+            f = (b & c) | (d & (b | c))
+        else:
+            f = b ^ c ^ d
+        tmp = _rotl(a, 5) + f + e + np.uint32(_K[t // 20]) + w[t]
+        a, b, c, d, e = tmp, a, _rotl(b, 30), c, d
+    return [s + x for s, x in zip(state, (a, b, c, d, e))]
+
+
+def sha1_multibuffer(features):
+    """
+    SHA-1 of every row of a (n, 64) uint8 array, all rows in parallel.
+
+    Returns:
+        np.ndarray: (n, 20) uint8 digests.
+    """
+    features = np.ascontiguousarray(features, dtype=np.uint8)
+    words = features.view(">u4").astype(np.uint32)
+    # Lanes are columns so each round touches contiguous memory
+    w = _schedule([np.ascontiguousarray(words[:, i]) for i in range(16)])
+    with np.errstate(over="ignore"):
+        state = [np.full(len(features), h, dtype=np.uint32) for h in _H0]
+        state = _compress(state, w)
+        state = _compress(state, _PAD64)
+    return np.stack(state, axis=1).astype(">u4").view(np.uint8)
+
+
+def sha1_scalar(features):
+    """Reference kernel: one hashlib call per feature."""
+    features = np.ascontiguousarray(features, dtype=np.uint8)
+    out = np.empty((len(features), 20), dtype=np.uint8)
+    view = memoryview(features).cast("B")
+    sha1 = hashlib.sha1
+    for i in range(len(features)):
+        out[i] = np.frombuffer(sha1(view[i * FEATURE_SIZE:(i + 1) * FEATURE_SIZE]).digest(), dtype=np.uint8)
+    return out
+
+
+def cpu_has_sha_ni():
+    """True when /proc/cpuinfo advertises the SHA extensions."""
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("flags"):
+                    return "sha_ni" in line.split()
+    except OSError:
+        pass
+    return False
+
+
+def select_kernel(n_features):
+    """Name of the kernel to use for a batch of n_features."""
+    forced = os.environ.get("FEATURE_HASH_KERNEL")
+    if forced:
+        if forced not in KERNELS:
+            raise ValueError(f"FEATURE_HASH_KERNEL must be one of {KERNELS}, got {forced!r}")
+        return forced
+    return "multibuffer" if n_features >= MIN_MULTIBUFFER_LANES else "scalar"
+
+
+def feature_windows(data, step=1):
+    """Zero-copy (n, 64) view of every 64-byte window of a byte string."""
+    arr = np.frombuffer(data, dtype=np.uint8)
+    if len(arr) < FEATURE_SIZE:
+        return np.empty((0, FEATURE_SIZE), dtype=np.uint8)
+    return np.lib.stride_tricks.sliding_window_view(arr, FEATURE_SIZE)[::step]
+
+
+def hash_features(features, kernel=None):
+    """SHA-1 digests of a (n, 64) feature array with the selected kernel."""
+    kernel = kernel or select_kernel(len(features))
+    if kernel == "multibuffer":
+        return sha1_multibuffer(features)
+    return sha1_scalar(features)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark feature-hashing kernels")
+    parser.add_argument("files", nargs="*", type=Path, help="Binaries to hash (default: output/*/*/*_base)")
+    parser.add_argument("--step", type=int, default=1, help="Feature stride in bytes")
+    args = parser.parse_args()
+
+    files = args.files or sorted(OUTPUT_DIR.glob("*/*/*_base"))
+    features = np.concatenate([feature_windows(p.read_bytes(), args.step) for p in files])
+    print(f"{len(files)} files, {len(features):,} features")
+    print(f"SHA-NI available to OpenSSL: {cpu_has_sha_ni()}; "
+          f"dispatch selects '{select_kernel(len(features))}' for this batch")
+
+    timings = {}
+    digests = {}
+    for kernel in KERNELS:
+        start = time.perf_counter()
+        digests[kernel] = hash_features(features, kernel)
+        timings[kernel] = time.perf_counter() - start
+    if not np.array_equal(digests["scalar"], digests["multibuffer"]):
+        raise SystemExit("[FATAL ERROR] Kernels disagree")
+
+    baseline = len(features) / timings["scalar"]
+    for kernel in KERNELS:
+        rate = len(features) / timings[kernel]
+        print(f" {kernel:<12} {rate:>14,.0f} features/s  ({rate / baseline:.2f}x scalar)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""
+Function boundary recovery for stripped binaries.
+
+The _stripped variants have no .symtab, but every compiler-generated function
+still has an FDE in .eh_frame (needed for unwinding), which gives its exact
+[start, end) range. The hand-written crt helpers (deregister_tm_clones,
+frame_dummy, ...) have no FDE; they are found by scanning the code that no FDE
+covers, split at direct call/jump targets, rip-relative lea targets and
+R_X86_64_RELATIVE relocation addends (function pointers such as .init_array
+entries), with nop/int3 padding trimmed.
+
+Run directly to recover every output/*/*/*_stripped binary, validate the
+starts and sizes against the unstripped _base twin and report the runtime per
+binary.
+"""
+import argparse
+import struct
+import time
+from pathlib import Path
+
+import elf_utils
+import x86_decode as X
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+
+# DWARF exception-header pointer encodings
+DW_EH_PE_omit = 0xFF
+DW_EH_PE_pcrel = 0x10
+DW_EH_PE_datarel = 0x30
+
+
+def _uleb128(data, pos):
+    result = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return result, pos
+
+
+def _sleb128(data, pos):
+    result = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            if byte & 0x40:
+                result -= 1 << shift
+            return result, pos
+
+
+def read_encoded(data, pos, encoding, section_addr, data_base=0):
+    """Decode one DW_EH_PE-encoded pointer at data[pos]; returns (value, new_pos)."""
+    fmt = encoding & 0x0F
+    if fmt == 0x01:
+        value, new_pos = _uleb128(data, pos)
+    elif fmt == 0x09:
+        value, new_pos = _sleb128(data, pos)
+    else:
+        code, size = {0x00: ("<Q", 8), 0x02: ("<H", 2), 0x03: ("<I", 4), 0x04: ("<Q", 8),
+                      0x0A: ("<h", 2), 0x0B: ("<i", 4), 0x0C: ("<q", 8)}[fmt]
+        value = struct.unpack_from(code, data, pos)[0]
+        new_pos = pos + size
+    application = encoding & 0x70
+    if application == DW_EH_PE_pcrel:
+        value += section_addr + pos
+    elif application == DW_EH_PE_datarel:
+        value += data_base
+    return value & 0xFFFFFFFFFFFFFFFF, new_pos
+
+
+def parse_eh_frame(elf):
+    """
+    (pc_begin, pc_range) of every FDE in .eh_frame.
+
+    CIEs are parsed only as far as their augmentation data, which carries the
+    pointer encoding ('R') used by the FDEs that reference them.
+    """
+    section = elf.section(".eh_frame")
+    if section is None:
+        return []
+    data = bytes(elf.section_bytes(section))
+    cie_encodings = {}
+    fdes = []
+    pos = 0
+    while pos + 4 <= len(data):
+        length = struct.unpack_from("<I", data, pos)[0]
+        if length == 0:
+            break
+        header = 4
+        if length == 0xFFFFFFFF:
+            length = struct.unpack_from("<Q", data, pos + 4)[0]
+            header = 12
+        record = pos + header
+        end = record + length
+        cie_id = struct.unpack_from("<I", data, record)[0]
+        if cie_id == 0:
+            cie_encodings[pos] = _cie_fde_encoding(data, record + 4, section.addr)
+        else:
+            cie_pos = record - cie_id
+            encoding = cie_encodings.get(cie_pos, 0x00)
+            pc_begin, p = read_encoded(data, record + 4, encoding, section.addr)
+            pc_range, _ = read_encoded(data, p, encoding & 0x0F, section.addr)
+            fdes.append((pc_begin, pc_range))
+        pos = end
+    return fdes
+
+
+def _cie_fde_encoding(data, pos, section_addr):
+    """Pointer encoding of a CIE's FDEs (augmentation 'R'); absptr when absent."""
+    version = data[pos]
+    pos += 1
+    aug_end = data.index(b"\0", pos)
+    augmentation = data[pos:aug_end].decode()
+    pos = aug_end + 1
+    _, pos = _uleb128(data, pos)          # code alignment
+    _, pos = _sleb128(data, pos)          # data alignment
+    if version == 1:
+        pos += 1                          # return address register
+    else:
+        _, pos = _uleb128(data, pos)
+    if not augmentation.startswith("z"):
+        return 0x00
+    _, pos = _uleb128(data, pos)          # augmentation data length
+    for ch in augmentation[1:]:
+        if ch == "R":
+            return data[pos]
+        if ch == "P":
+            enc = data[pos]
+            _, pos = read_encoded(data, pos + 1, enc & 0x7F, section_addr)
+        elif ch == "L":
+            pos += 1
+    return 0x00
+
+
+def parse_eh_frame_hdr(elf):
+    """
+    Function starts from the sorted binary-search table in .eh_frame_hdr.
+
+    This is the fast path when only starts are needed; the table is normally
+    datarel|sdata4 pairs (initial_location, fde_address).
+    """
+    section = elf.section(".eh_frame_hdr")
+    if section is None:
+        return []
+    data = bytes(elf.section_bytes(section))
+    version, frame_ptr_enc, count_enc, table_enc = data[:4]
+    if version != 1 or count_enc == DW_EH_PE_omit or table_enc == DW_EH_PE_omit:
+        return []
+    _, pos = read_encoded(data, 4, frame_ptr_enc, section.addr, section.addr)
+    count, pos = read_encoded(data, pos, count_enc, section.addr, section.addr)
+    starts = []
+    for _ in range(count):
+        start, pos = read_encoded(data, pos, table_enc, section.addr, section.addr)
+        _, pos = read_encoded(data, pos, table_enc, section.addr, section.addr)
+        starts.append(start)
+    return starts
+
+
+def code_references(elf, text):
+    """Addresses inside .text that code or data points at."""
+    refs = {elf.entry} if text.contains(elf.entry) else set()
+    refs.update(start for start in parse_eh_frame_hdr(elf) if text.contains(start))
+    for section in elf.executable_sections():
+        for insn in X.sweep(elf.section_bytes(section), section.addr):
+            if insn.flow in (X.FLOW_CALL, X.FLOW_JMP) and text.contains(insn.target):
+                refs.add(insn.target)
+            elif insn.rip_relative and insn.map == X.MAP_1BYTE and insn.opcode == 0x8D:
+                target = insn.end + insn.disp
+                if text.contains(target):
+                    refs.add(target)
+    relocs = elf.relocations(".rela.dyn")
+    for addend in relocs["addend"][(relocs["info"] & 0xFFFFFFFF) == elf_utils.R_X86_64_RELATIVE]:
+        if text.contains(int(addend)):
+            refs.add(int(addend))
+    return refs
+
+
+def _trim_padding(elf, text, start, end):
+    """Move start past leading padding and end before trailing padding."""
+    code = elf.section_bytes(text)
+    insns = list(X.sweep(code, text.addr, start - text.addr, end - text.addr))
+    body = [i for i in insns if not (i.is_nop or (i.map == X.MAP_1BYTE and i.opcode == 0xCC))]
+    if not body:
+        return None
+    first = body[0].addr
+    last = body[-1].end
+    return first, last
+
+
+def recover_functions(elf):
+    """
+    Function (start, size, name) list for a binary, with or without symbols.
+
+    Names are sub_<addr>; the entry point is named _start.
+    """
+    text = elf.section(".text")
+    if text is None:
+        return []
+    fdes = sorted((start, size) for start, size in parse_eh_frame(elf) if text.contains(start))
+    covered = [(start, start + size) for start, size in fdes]
+    funcs = {start: size for start, size in fdes}
+
+    # Everything not covered by an FDE is split at referenced addresses
+    refs = code_references(elf, text)
+    cursor = text.addr
+    gaps = []
+    for start, end in covered + [(text.addr + text.size, text.addr + text.size)]:
+        if start > cursor:
+            gaps.append((cursor, start))
+        cursor = max(cursor, end)
+    for gap_start, gap_end in gaps:
+        cuts = sorted({gap_start, *[r for r in refs if gap_start < r < gap_end]})
+        for i, cut in enumerate(cuts):
+            piece_end = cuts[i + 1] if i + 1 < len(cuts) else gap_end
+            trimmed = _trim_padding(elf, text, cut, piece_end)
+            if trimmed:
+                funcs[trimmed[0]] = trimmed[1] - trimmed[0]
+
+    return [(start, size, "_start" if start == elf.entry else f"sub_{start:x}")
+            for start, size in sorted(funcs.items())]
+
+
+def validate(recovered, reference):
+    """Compare recovered (start, size) against symbol-table functions of the twin."""
+    truth = {start: size for start, size, _ in reference}
+    found = {start: size for start, size, _ in recovered}
+    hits = set(truth) & set(found)
+    sized = [s for s in hits if truth[s]]
+    return {
+        "true": len(truth),
+        "recovered": len(found),
+        "matched": len(hits),
+        "precision": len(hits) / len(found) if found else 0.0,
+        "recall": len(hits) / len(truth) if truth else 0.0,
+        "size_match": sum(truth[s] == found[s] for s in sized) / len(sized) if sized else 1.0,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Recover function boundaries in stripped binaries")
+    parser.add_argument("files", nargs="*", type=Path, help="Stripped binaries (default: output/*/*/*_stripped)")
+    parser.add_argument("--verbose", action="store_true", help="Print every binary")
+    args = parser.parse_args()
+
+    files = args.files or sorted(OUTPUT_DIR.glob("*/*/*_stripped"))
+    totals = {"true": 0, "recovered": 0, "matched": 0}
+    size_scores = []
+    timings = []
+    for path in files:
+        start = time.perf_counter()
+        elf = elf_utils.ELFFile(path)
+        recovered = recover_functions(elf)
+        timings.append(time.perf_counter() - start)
+
+        twin = path.with_name(path.name.replace("_stripped", "_base"))
+        if not twin.is_file():
+            continue
+        twin_elf = elf_utils.ELFFile(twin)
+        text = twin_elf.section(".text")
+        reference = [f for f in twin_elf.functions() if text.contains(f[0])]
+        result = validate(recovered, reference)
+        for key in totals:
+            totals[key] += result[key]
+        size_scores.append(result["size_match"])
+        if args.verbose or result["recall"] < 1.0:
+            print(f" {path.relative_to(OUTPUT_DIR) if OUTPUT_DIR in path.parents else path}: "
+                  f"{result['matched']}/{result['true']} starts, precision {result['precision']:.2f}, "
+                  f"{timings[-1] * 1e3:.2f} ms")
+
+    if not timings:
+        print("No binaries found.")
+        return
+    print(f"\nBinaries: {len(files)}")
+    if totals["true"]:
+        print(f"Starts recovered: {totals['matched']}/{totals['true']} "
+              f"(recall {totals['matched'] / totals['true']:.3f}, "
+              f"precision {totals['matched'] / max(totals['recovered'], 1):.3f})")
+        print(f"Sized functions with exact size: {sum(size_scores) / len(size_scores):.3f}")
+    print(f"Runtime per binary: mean {sum(timings) / len(timings) * 1e3:.2f} ms, "
+          f"max {max(timings) * 1e3:.2f} ms")
+
+
+if __name__ == "__main__":
+    main()
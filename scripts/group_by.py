@@ -0,0 +1,147 @@
+"""
+Single-pass group-by over dictionary-encoded result columns.
+
+The category codes of the grouping columns (result_store.ResultTable.codes)
+are combined into one mixed-radix cell number per row, and one stable sort
+of that number (a radix sort for the usual <= 65536 cells) lays the scores of
+every cell out contiguously, in their original row order. count, mean,
+median and std of all cells then come from views of that one array, instead
+of one boolean mask over the whole table per (group, tool, variant).
+
+The per-cell reductions are the ones pandas applies to a masked Series: a
+float64 sum over the rows in table order divided by the count, the sum of
+squared deviations from that mean over count - 1, and numpy's median. Since
+the rows of a cell keep their order, the results are the same doubles
+analyze_csv.py used to get from its masks, not just close to them.
+
+Codes can be remapped before grouping (remap=) to merge several values into
+one cell, e.g. the two baseline variants, or to drop rows (code -1).
+"""
+import numpy as np
+
+AGGREGATES = ["count", "mean", "median", "std"]
+
+
+def _key_dtype(cells):
+    for dtype in (np.uint16, np.uint32):
+        if cells <= np.iinfo(dtype).max + 1:
+            return dtype
+    return np.uint64
+
+
+class Cells:
+    """Scores of every cell of a group-by, sorted by cell."""
+
+    def __init__(self, codes, sizes, scores, remap=None):
+        """
+        Args:
+            codes: list of integer code arrays, one per grouping column
+            sizes: number of distinct codes of each column (after remap)
+            scores: values to aggregate, same length as the code arrays
+            remap: optional {column index: int array old code -> new code or -1}
+        """
+        self.sizes = tuple(int(s) for s in sizes)
+        self.cells = int(np.prod(self.sizes, dtype=np.int64))
+        dtype = _key_dtype(self.cells + 1)
+        key = np.zeros(len(scores), dtype=np.int64)
+        keep = np.ones(len(scores), dtype=bool)
+        for column, (column_codes, size) in enumerate(zip(codes, self.sizes)):
+            column_codes = np.asarray(column_codes)
+            if remap and column in remap:
+                column_codes = np.asarray(remap[column])[column_codes]
+                keep &= column_codes >= 0
+            key = key * size + column_codes
+        # Dropped rows sort past the last cell
+        key = np.where(keep, key, self.cells).astype(dtype)
+        order = np.argsort(key, kind="stable")
+        self.values = np.asarray(scores, dtype=np.float64)[order]
+        self.counts = np.bincount(key, minlength=self.cells + 1)[:self.cells]
+        self.starts = np.concatenate(([0], np.cumsum(self.counts)[:-1]))
+
+    def cell(self, *index):
+        """Flat cell number of one code tuple."""
+        return int(np.ravel_multi_index(index, self.sizes))
+
+    def scores(self, *index):
+        """Scores of one cell in table order."""
+        i = self.cell(*index)
+        return self.values[self.starts[i]:self.starts[i] + self.counts[i]]
+
+    def aggregate(self):
+        """
+        count, mean, median and std (ddof=1) of every cell; NaN where undefined.
+
+        Returns:
+            dict: aggregate name -> array shaped like sizes
+        """
+        mean = np.full(self.cells, np.nan)
+        median = np.full(self.cells, np.nan)
+        std = np.full(self.cells, np.nan)
+        for i in np.flatnonzero(self.counts):
+            values = self.values[self.starts[i]:self.starts[i] + self.counts[i]]
+            n = len(values)
+            mean[i] = values.sum(dtype=np.float64) / n
+            median[i] = np.median(values)
+            if n > 1:
+                std[i] = np.sqrt(((mean[i] - values) ** 2).sum(dtype=np.float64) / (n - 1))
+        return {name: array.reshape(self.sizes) for name, array in
+                zip(AGGREGATES, (self.counts, mean, median, std))}
+
+
+def remap_codes(categories, groups):
+    """
+    Code remap putting listed values into numbered buckets.
+
+    Args:
+        categories: distinct values of the column, indexed by code
+        groups: list of value lists; values in groups[k] map to k
+
+    Returns:
+        numpy array: old code -> bucket, -1 for values not listed
+    """
+    bucket = {value: k for k, values in enumerate(groups) for value in values}
+    return np.array([bucket.get(value, -1) for value in categories], dtype=np.int64)
+
+
+def defense_effectiveness(table, scores, baseline_variants, defense_variants):
+    """
+    Rows of analyze_csv.py's defense_effectiveness table from one grouping pass.
+
+    Baseline variants are merged into one bucket and every defense variant
+    gets its own, so (group, tool, bucket) cells hold exactly the rows the
+    old per-combination masks selected, in the same order.
+
+    Args:
+        table: result_store.ResultTable (codes and categories)
+        scores: float64 scores aligned with the table rows (radiff2 already rescaled)
+
+    Returns:
+        list: dicts with the Group, Tool, Variant, Baseline_Score, Defense_Score,
+        Absolute_Reduction and Percent_Reduction columns
+    """
+    groups, tools = table.categories("Group"), table.categories("Tool")
+    buckets = [list(baseline_variants)] + [[v] for v in defense_variants]
+    cells = Cells([table.codes("Group"), table.codes("Tool"), table.codes("Variant")],
+                  [len(groups), len(tools), len(buckets)], scores,
+                  remap={2: remap_codes(table.categories("Variant"), buckets)})
+    means = cells.aggregate()["mean"]
+
+    rows = []
+    for g, group in enumerate(groups):
+        for t, tool in enumerate(tools):
+            baseline_mean = means[g, t, 0]
+            for v, variant in enumerate(defense_variants, start=1):
+                defense_mean = means[g, t, v]
+                if np.isnan(baseline_mean) or np.isnan(defense_mean):
+                    continue
+                absolute_reduction = baseline_mean - defense_mean
+                rows.append({
+                    "Group": group,
+                    "Tool": tool,
+                    "Variant": variant,
+                    "Baseline_Score": baseline_mean,
+                    "Defense_Score": defense_mean,
+                    "Absolute_Reduction": absolute_reduction,
+                    "Percent_Reduction": (absolute_reduction / baseline_mean) * 100 if baseline_mean > 0 else 0,
+                })
+    return rows
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+Compiler-idiom fingerprints: which toolchain and optimization level built a binary.
+
+A small pattern database of byte idioms (prologues, stack-protector
+sequences, endbr64 placement, O0 argument spills, loop-alignment padding,
+SSE vector code) is compiled into one Aho-Corasick automaton, and every
+executable section is scanned once. Matches count only inside the program's
+own functions, those reachable from main in call_graph (so stripped binaries
+work too), and patterns marked ENTRY only when they start at the entry.
+
+Every pattern carries one tag:
+
+  toolchain:gcc / toolchain:clang   evidence for the compiler
+  opt:O0 / opt:O2+                  evidence for the optimization level
+  feature:...                       hardening or code-generation features
+
+The toolchain and optimization verdicts of a binary are the tags with the
+most matching patterns on each axis. Over the corpus (no files given) it
+writes idioms.csv (one row per binary with per-pattern counts and the
+verdicts) and idiom_functions.csv (the tags found in each function).
+"""
+import argparse
+import bisect
+import csv
+import os
+import struct
+import time
+from collections import Counter, deque
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import call_graph
+import cfg
+import elf_utils
+from cfg_metrics import describe_binary
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+IDIOMS_CSV = "idioms.csv"
+FUNCTIONS_CSV = "idiom_functions.csv"
+ENTRY = "entry"
+ANY = "any"
+
+# (name, tag, hex bytes, where). Register variants of one idiom share a name.
+PATTERNS = [
+    # gcc on this toolchain defaults to -fcf-protection and -fstack-protector-strong
+    ("endbr64-entry", "toolchain:gcc", "f3 0f 1e fa", ENTRY),
+    ("canary-load", "toolchain:gcc", "64 48 8b 04 25 28 00 00 00", ANY),
+    ("canary-load", "toolchain:gcc", "64 48 8b 0c 25 28 00 00 00", ANY),
+    ("canary-load", "toolchain:gcc", "64 48 8b 14 25 28 00 00 00", ANY),
+    ("canary-load", "toolchain:gcc", "64 48 8b 1c 25 28 00 00 00", ANY),
+    ("canary-check-sub", "feature:stack-protector", "64 48 2b 04 25 28 00 00 00", ANY),
+    ("canary-check-sub", "feature:stack-protector", "64 48 2b 0c 25 28 00 00 00", ANY),
+    ("canary-check-sub", "feature:stack-protector", "64 48 2b 14 25 28 00 00 00", ANY),
+    ("canary-check-sub", "feature:stack-protector", "64 48 2b 1c 25 28 00 00 00", ANY),
+    # clang saves rbp first and counts loops with inc
+    ("push-rbp-r15", "toolchain:clang", "55 41 57", ANY),
+    ("inc-r64", "toolchain:clang", "49 ff c4", ANY),
+    ("inc-r64", "toolchain:clang", "49 ff c5", ANY),
+    ("inc-r64", "toolchain:clang", "49 ff c6", ANY),
+    ("inc-r64", "toolchain:clang", "49 ff c7", ANY),
+    # -O0: frame pointer, arguments spilled to the frame, leave
+    ("frame-setup", "opt:O0", "f3 0f 1e fa 55 48 89 e5", ENTRY),
+    ("spill-edi", "opt:O0", "89 7d", ANY),
+    ("spill-rdi", "opt:O0", "48 89 7d", ANY),
+    ("leave-ret", "opt:O0", "c9 c3", ANY),
+    # Loop alignment only happens from -O2 on (9/4/2-byte nops inside code)
+    ("align-nop9", "opt:O2+", "66 0f 1f 84 00 00 00 00 00", ANY),
+    ("align-nop4", "opt:O2+", "0f 1f 40 00", ANY),
+    ("align-xchg", "opt:O2+", "66 90", ANY),
+    ("push-r12-rbp-rbx", "opt:O2+", "41 54 55 53", ANY),
+    # Packed-integer SSE from the vectorizer
+    ("sse-pshufd", "feature:simd", "66 0f 70", ANY),
+    ("sse-paddd", "feature:simd", "66 0f fe", ANY),
+    ("sse-movdqa", "feature:simd", "66 0f 6f", ANY),
+    ("sse-movdqu", "feature:simd", "f3 0f 6f", ANY),
+]
+# Counted per program function from what its entry lacks: clang here does not
+# enable -fcf-protection, and only -O0 sets up rbp in every function
+PLAIN_ENTRY = "plain-entry"
+FRAMELESS_ENTRY = "frameless-entry"
+PATTERN_NAMES = list(dict.fromkeys(name for name, _, _, _ in PATTERNS)) + [PLAIN_ENTRY, FRAMELESS_ENTRY]
+TAG_OF = {name: tag for name, tag, _, _ in PATTERNS}
+TAG_OF.update({PLAIN_ENTRY: "toolchain:clang", FRAMELESS_ENTRY: "opt:O2+"})
+_ENDBR64 = bytes.fromhex("f30f1efa")
+_FRAME_SETUP = bytes.fromhex("554889e5")
+
+
+class Automaton:
+    """Aho-Corasick automaton over bytes with a dense 256-way transition table."""
+
+    def __init__(self, patterns):
+        self.lengths = [len(p) for p in patterns]
+        goto = [{}]
+        outputs = [[]]
+        for index, pattern in enumerate(patterns):
+            state = 0
+            for byte in pattern:
+                if byte not in goto[state]:
+                    goto.append({})
+                    outputs.append([])
+                    goto[state][byte] = len(goto) - 1
+                state = goto[state][byte]
+            outputs[state].append(index)
+
+        # Breadth-first: fail links, inherited outputs, then the full transition rows
+        fail = [0] * len(goto)
+        self.delta = [None] * len(goto)
+        self.delta[0] = [goto[0].get(b, 0) for b in range(256)]
+        queue = deque(goto[0].values())
+        while queue:
+            state = queue.popleft()
+            outputs[state] = outputs[state] + outputs[fail[state]]
+            row = list(self.delta[fail[state]])
+            for byte, child in goto[state].items():
+                row[byte] = child
+                fail[child] = self.delta[fail[state]][byte]
+                queue.append(child)
+            self.delta[state] = row
+        self.outputs = [tuple(o) for o in outputs]
+
+    def scan(self, data):
+        """(start offset, pattern index) of every match, overlapping ones included."""
+        delta, outputs, lengths = self.delta, self.outputs, self.lengths
+        state = 0
+        matches = []
+        for end, byte in enumerate(data, 1):
+            state = delta[state][byte]
+            if outputs[state]:
+                matches.extend((end - lengths[i], i) for i in outputs[state])
+        return matches
+
+
+_AUTOMATON = Automaton([bytes.fromhex(p) for _, _, p, _ in PATTERNS])
+
+
+def _verdict(counts, axis):
+    """Tag of one axis ("toolchain", "opt") with the most pattern matches, or "unknown"."""
+    votes = Counter()
+    for name, count in counts.items():
+        if TAG_OF[name].startswith(axis + ":"):
+            votes[TAG_OF[name].split(":", 1)[1]] += count
+    if not votes:
+        return "unknown"
+    (best, top), *rest = votes.most_common()
+    return "unknown" if rest and rest[0][1] == top else best
+
+
+def scan_binary(path):
+    """
+    Idiom matches in the program's own functions.
+
+    Only functions reachable from main (call_graph.extract) are counted: the
+    crt startup code and PLT are linked from the same gcc-built objects into
+    every binary and would vote gcc for clang builds too. A program function
+    whose entry is not endbr64 counts as plain-entry (clang evidence), one
+    without push rbp; mov rbp, rsp as frameless-entry (optimized).
+
+    Returns:
+        tuple: (Counter {pattern name: matches}, {toolchain, opt} verdicts,
+                [(function name, start, sorted tags)])
+    """
+    elf = elf_utils.ELFFile(path)
+    program = {node for node in call_graph.extract(path).names if isinstance(node, int)}
+    ranges = [r for r in cfg.function_ranges(elf) if r[0] in program]
+    starts = [start for start, _, _ in ranges]
+    counts = Counter()
+    tags = [set() for _ in ranges]
+    for section in elf.executable_sections():
+        for offset, index in _AUTOMATON.scan(elf.section_bytes(section)):
+            name, tag, _, where = PATTERNS[index]
+            addr = section.addr + offset
+            i = bisect.bisect_right(starts, addr) - 1
+            if i < 0 or addr >= starts[i] + ranges[i][1] or (where == ENTRY and addr != starts[i]):
+                continue
+            counts[name] += 1
+            tags[i].add(tag)
+    for i, start in enumerate(starts):
+        entry = bytes(elf.read(start, 8) or b"")
+        missing = []
+        if not entry.startswith(_ENDBR64):
+            missing.append(PLAIN_ENTRY)
+        if not entry.removeprefix(_ENDBR64).startswith(_FRAME_SETUP):
+            missing.append(FRAMELESS_ENTRY)
+        for name in missing:
+            counts[name] += 1
+            tags[i].add(TAG_OF[name])
+    verdicts = {"toolchain": _verdict(counts, "toolchain"), "opt": _verdict(counts, "opt")}
+    functions = [(name, start, sorted(t)) for (start, _, name), t in zip(ranges, tags)]
+    return counts, verdicts, functions
+
+
+def _scan(path):
+    try:
+        return path, *scan_binary(path), None
+    except (ValueError, IndexError, OSError, struct.error) as e:
+        return path, Counter(), {}, [], str(e)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Toolchain and optimization-level idiom scanner")
+    parser.add_argument("files", nargs="*", type=Path,
+                        help="Binaries to scan (default: every binary under --output-dir)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--csv", default=IDIOMS_CSV, help="Per-binary output for a corpus run")
+    parser.add_argument("--functions-csv", default=FUNCTIONS_CSV, help="Per-function output for a corpus run")
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    if args.files:
+        for f in args.files:
+            counts, verdicts, functions = scan_binary(f)
+            print(f"{f}: toolchain={verdicts['toolchain']} opt={verdicts['opt']}")
+            for name in PATTERN_NAMES:
+                if counts[name]:
+                    print(f"  {name:<20} {TAG_OF[name]:<24} {counts[name]}")
+            for name, start, tags in functions:
+                if tags:
+                    print(f"  {start:#x} {name}: {', '.join(tags)}")
+        return
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Scanning {len(files)} binaries for {len(PATTERNS)} idiom patterns...")
+    start = time.perf_counter()
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        results = list(pool.map(_scan, [str(f) for f in files], chunksize=8))
+    elapsed = time.perf_counter() - start
+
+    binary_rows, function_rows = [], []
+    agreement = Counter()
+    for path, counts, verdicts, functions, error in results:
+        if error:
+            print(f" [Error] {path}: {error}")
+            continue
+        info = describe_binary(path, args.output_dir)
+        key = {"task": info["task"], "group": info["group"], "binary": info["binary"]}
+        binary_rows.append({**key, "defense": info["defense"], **verdicts,
+                            **{name: counts[name] for name in PATTERN_NAMES}})
+        function_rows.extend({**key, "function": name, "address": hex(addr), "tags": " ".join(tags)}
+                             for name, addr, tags in functions)
+        agreement[(info["defense"], verdicts["toolchain"], verdicts["opt"])] += 1
+
+    with open(args.csv, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=["task", "group", "binary", "defense", "toolchain", "opt",
+                                               *PATTERN_NAMES])
+        writer.writeheader()
+        writer.writerows(binary_rows)
+    with open(args.functions_csv, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=["task", "group", "binary", "function", "address", "tags"])
+        writer.writeheader()
+        writer.writerows(function_rows)
+
+    print(f"Done in {elapsed:.2f}s. Verdicts per defense:")
+    for (defense, toolchain, opt), count in sorted(agreement.items()):
+        print(f"  {defense:<10} toolchain={toolchain:<8} opt={opt:<8} {count:>4} binaries")
+    print(f"Results saved to: {args.csv}, {args.functions_csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Import-set fingerprints and their Jaccard similarity.
+
+The imports of a binary are read straight from the .dynsym view of
+elf_utils (no copies): every undefined named symbol plus the data objects
+pulled in by copy relocations (stdin, stderr, ...). .dynsym survives
+stripping, so this works on every variant. The startup symbols every binary
+imports are dropped, and fortified names are folded onto their plain form
+(__printf_chk -> printf) because only gcc -O2 builds use them here.
+
+A set of binaries shares one sorted dictionary of all their import names;
+each binary becomes a bitset over it (packed uint64 words). Every row is
+popcounted once; intersections come from popcounts of the AND of the words,
+a block of rows against all rows at a time so memory stays O(block x n x
+words), and unions are |a| + |b| - |a & b|. Scores are Jaccard on the 0-100
+scale of the other tools.
+"""
+import argparse
+import csv
+import itertools
+import os
+import re
+import struct
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+import elf_utils
+from sdhash_index import POPCOUNT8
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+PAIRS_CSV = "imports_pairs.csv"
+R_X86_64_COPY = 5
+# Imported by the crt startup code of every binary, whatever the program does
+CRT_IMPORTS = frozenset([
+    "__libc_start_main", "__cxa_finalize", "__gmon_start__",
+    "_ITM_deregisterTMCloneTable", "_ITM_registerTMCloneTable",
+])
+# Rows of the all-pairs matrix computed at once; bounds the AND temporaries
+BLOCK_ROWS = 256
+_FORTIFIED = re.compile(r"^__(\w+)_chk$")
+
+
+def imports(path, fold_fortify=True):
+    """Sorted import names of one binary."""
+    elf = elf_utils.ELFFile(path)
+    syms, name_of = elf.symbols(".dynsym")
+    wanted = (syms["shndx"] == 0) & (syms["name"] != 0)
+    rela = elf.relocations(".rela.dyn")
+    copied = (rela["info"] >> np.uint64(32))[(rela["info"] & np.uint64(0xFFFFFFFF)) == R_X86_64_COPY]
+    wanted[copied[copied < len(syms)].astype(np.int64)] = True
+    names = set()
+    for offset in syms["name"][wanted]:
+        name = name_of(offset)
+        if fold_fortify:
+            name = _FORTIFIED.sub(r"\1", name)
+        if name and name not in CRT_IMPORTS:
+            names.add(name)
+    return sorted(names)
+
+
+def _imports(args):
+    path, fold_fortify = args
+    try:
+        return path, imports(path, fold_fortify), None
+    except (ValueError, IndexError, OSError, struct.error) as e:
+        return path, [], str(e)
+
+
+def import_sets(files, fold_fortify=True, workers=None):
+    """
+    Import names of every file, read in parallel unless workers == 1.
+
+    Returns:
+        tuple: ([sorted names per file], {path: error})
+    """
+    jobs = [(str(f), fold_fortify) for f in files]
+    if workers == 1:
+        results = list(map(_imports, jobs))
+    else:
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            results = list(pool.map(_imports, jobs, chunksize=16))
+    return [names for _, names, _ in results], {path: error for path, _, error in results if error}
+
+
+def bitsets(sets):
+    """
+    Bitsets of import sets over their shared dictionary.
+
+    Returns:
+        tuple: (dictionary list, uint64 array of shape (files, words))
+    """
+    dictionary = sorted(set().union(*sets))
+    column = {name: i for i, name in enumerate(dictionary)}
+    bits = np.zeros((len(sets), max(len(dictionary), 1)), dtype=bool)
+    for row, names in enumerate(sets):
+        bits[row, [column[n] for n in names]] = True
+    packed = np.packbits(bits, axis=1, bitorder="little")
+    packed = np.pad(packed, ((0, 0), (0, -packed.shape[1] % 8)))
+    return dictionary, packed.view(np.uint64)
+
+
+def _popcount(words):
+    """Set bits per row of uint64 words, summed over the last axis."""
+    return POPCOUNT8[words.view(np.uint8)].sum(axis=-1, dtype=np.int64)
+
+
+def similarity_matrix(words, block_rows=BLOCK_ROWS):
+    """All-pairs Jaccard of bitset rows on the 0-100 scale; two empty sets score 100."""
+    words = np.ascontiguousarray(words)
+    pop = _popcount(words)
+    scores = np.empty((len(words), len(words)))
+    for start in range(0, len(words), block_rows):
+        block = words[start:start + block_rows]
+        shared = _popcount(block[:, None, :] & words[None, :, :])
+        union = pop[start:start + block_rows, None] + pop[None, :] - shared
+        with np.errstate(invalid="ignore", divide="ignore"):
+            scores[start:start + block_rows] = np.where(union > 0, 100 * shared / union, 100.0)
+    return np.round(scores, 2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Import-set fingerprints and Jaccard similarity")
+    parser.add_argument("files", nargs="*", type=Path,
+                        help="Binaries to compare (default: every binary under --output-dir)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--csv", default=PAIRS_CSV, help="All-pairs output when run over the corpus")
+    parser.add_argument("--keep-fortify", action="store_true", help="Keep __*_chk names distinct")
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    files = args.files or sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    start = time.perf_counter()
+    sets, errors = import_sets(files, not args.keep_fortify, args.workers)
+    dictionary, words = bitsets(sets)
+    scores = similarity_matrix(words)
+    elapsed = time.perf_counter() - start
+    for path, error in errors.items():
+        print(f" [Error] {path}: {error}")
+
+    if args.files:
+        for f, names in zip(files, sets):
+            print(f"{f}: {' '.join(names)}")
+        for i, j in itertools.combinations(range(len(files)), 2):
+            print(f"{files[i].name} vs {files[j].name}: {scores[i, j]}")
+        return
+
+    names = [str(f.relative_to(args.output_dir)) for f in files]
+    with open(args.csv, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["File1", "File2", "Score"])
+        for i, j in zip(*np.triu_indices(len(files), k=1)):
+            writer.writerow([names[i], names[j], scores[i, j]])
+    print(f"Done in {elapsed * 1000:.0f} ms: {len(files)} binaries, {len(dictionary)} distinct imports "
+          f"({words.shape[1]} words per bitset), {len(files) * (len(files) - 1) // 2} pairs")
+    print(f"Pairs saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""
+Printable strings and sliding-window byte entropy of every loaded section.
+
+EncodeLiterals (_elit) replaces string literals with code that rebuilds them
+at run time, so format strings disappear from .rodata and reappear, if at
+all, as immediate fragments in .text. Both are measured here with whole-array
+numpy operations, one pass per binary:
+
+  - strings: maximal runs of printable ASCII (plus tab) of at least
+    MIN_STRING_LEN bytes, found from the edges of a lookup-table mask
+  - entropy: Shannon entropy in bits per byte of WINDOW-byte windows every
+    STEP bytes, with all windows of a section histogrammed in one bincount
+
+Over the corpus (no files given) it writes to --out:
+
+  strings.jsonl      one line per binary: task, group, binary, {section: [strings]}
+  entropy.csv        task, group, binary, section, offset, entropy (one row per window)
+  sections.csv       per section: size, strings, string bytes, mean/max entropy
+  elit_summary.csv   per program: .rodata strings of _base, how many survive
+                     anywhere in _elit, and the .rodata entropy of both
+"""
+import argparse
+import csv
+import json
+import os
+import struct
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+import elf_utils
+from cfg_metrics import describe_binary
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+PROFILE_DIR = "literal_profiles"
+MIN_STRING_LEN = 4
+WINDOW = 256
+STEP = 64
+# Section holding the literals EncodeLiterals removes
+LITERAL_SECTION = ".rodata"
+BASE_SUFFIX = "_base"
+ELIT_SUFFIX = "_elit"
+
+_PRINTABLE = np.zeros(256, dtype=bool)
+_PRINTABLE[0x20:0x7F] = True
+_PRINTABLE[0x09] = True
+
+
+def loaded_sections(path):
+    """
+    (name, bytes as uint8 array) of every section with file contents that is loaded.
+
+    Files without a usable section table are profiled whole as "(file)".
+    """
+    data = np.fromfile(path, dtype=np.uint8)
+    try:
+        elf = elf_utils.ELFFile(path)
+        sections = [(s.name, data[s.offset:s.offset + s.size]) for s in elf.sections
+                    if s.flags & elf_utils.SHF_ALLOC and s.type != elf_utils.SHT_NOBITS and s.size]
+    except (ValueError, IndexError, struct.error):
+        sections = []
+    return sections or [("(file)", data)]
+
+
+def printable_strings(data, min_len=MIN_STRING_LEN):
+    """Printable runs of at least min_len bytes, in order of appearance."""
+    mask = np.concatenate(([False], _PRINTABLE[data], [False]))
+    edges = np.flatnonzero(mask[1:] != mask[:-1])
+    starts, ends = edges[0::2], edges[1::2]
+    keep = ends - starts >= min_len
+    raw = data.tobytes()
+    return [raw[s:e].decode("ascii") for s, e in zip(starts[keep], ends[keep])]
+
+
+def window_entropy(data, window=WINDOW, step=STEP):
+    """
+    Entropy in bits per byte of every window of a byte array.
+
+    Sections shorter than a window are one window of their own length.
+
+    Returns:
+        tuple: (window offsets, entropies) as numpy arrays
+    """
+    if len(data) == 0:
+        return np.empty(0, dtype=np.int64), np.empty(0)
+    if len(data) <= window:
+        windows = data[None, :]
+    else:
+        windows = np.lib.stride_tricks.sliding_window_view(data, window)[::step]
+    n, width = windows.shape
+    counts = np.bincount((np.arange(n)[:, None] * 256 + windows).ravel(), minlength=n * 256).reshape(n, 256)
+    p = counts / width
+    logs = np.log2(p, out=np.zeros_like(p), where=p > 0)
+    return np.arange(n) * step, -(p * logs).sum(axis=1)
+
+
+def profile(path, min_len=MIN_STRING_LEN, window=WINDOW, step=STEP):
+    """{section: {"size", "strings", "offsets", "entropy"}} for one binary."""
+    result = {}
+    for name, data in loaded_sections(path):
+        offsets, entropy = window_entropy(data, window, step)
+        result[name] = {
+            "size": len(data),
+            "strings": printable_strings(data, min_len),
+            "offsets": offsets,
+            "entropy": entropy,
+        }
+    return result
+
+
+def _profile(args):
+    path, min_len, window, step = args
+    try:
+        return path, profile(path, min_len, window, step), None
+    except OSError as e:
+        return path, {}, str(e)
+
+
+def elit_summary(profiles, output_dir=OUTPUT_DIR):
+    """
+    One row per program that has both a _base and an _elit binary.
+
+    A .rodata string of the base binary survives when it still occurs as a
+    whole string in any loaded section of the _elit binary.
+    """
+    by_name = {}
+    for path, sections in profiles.items():
+        path = Path(path)
+        by_name[(path.parent, path.name)] = sections
+    rows = []
+    for (parent, name), base in sorted(by_name.items()):
+        if not name.endswith(BASE_SUFFIX):
+            continue
+        program = name[:-len(BASE_SUFFIX)]
+        elit = by_name.get((parent, program + ELIT_SUFFIX))
+        if elit is None:
+            continue
+        info = describe_binary(parent / name, output_dir)
+        literals = set(base.get(LITERAL_SECTION, {}).get("strings", []))
+        remaining = {s for section in elit.values() for s in section["strings"]}
+        survived = literals & remaining
+        rows.append({
+            "task": info["task"],
+            "group": info["group"],
+            "program": program,
+            "base_literals": len(literals),
+            "survived": len(survived),
+            "removed": len(literals) - len(survived),
+            "removed_fraction": round((len(literals) - len(survived)) / len(literals), 4) if literals else "",
+            "base_rodata_entropy": _mean_entropy(base.get(LITERAL_SECTION)),
+            "elit_rodata_entropy": _mean_entropy(elit.get(LITERAL_SECTION)),
+            "base_text_strings": len(base.get(".text", {}).get("strings", [])),
+            "elit_text_strings": len(elit.get(".text", {}).get("strings", [])),
+        })
+    return rows
+
+
+def _mean_entropy(section):
+    if not section or not len(section["entropy"]):
+        return ""
+    return round(float(section["entropy"].mean()), 4)
+
+
+def _write_csv(path, rows, fields):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Printable strings and windowed entropy per section")
+    parser.add_argument("files", nargs="*", type=Path,
+                        help="Binaries to profile (default: every binary under --output-dir)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--out", type=Path, default=Path(PROFILE_DIR), help="Directory for the corpus outputs")
+    parser.add_argument("--min-len", type=int, default=MIN_STRING_LEN)
+    parser.add_argument("--window", type=int, default=WINDOW)
+    parser.add_argument("--step", type=int, default=STEP)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    if args.files:
+        for f in args.files:
+            print(f"{f}:")
+            for name, section in profile(f, args.min_len, args.window, args.step).items():
+                entropy = section["entropy"]
+                print(f"  {name:<20} {section['size']:>7} bytes {len(section['strings']):>5} strings "
+                      f"entropy mean {entropy.mean():.2f} max {entropy.max():.2f}")
+        return
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Profiling {len(files)} binaries (strings >= {args.min_len} bytes, "
+          f"{args.window}-byte windows every {args.step})...")
+    start = time.perf_counter()
+    jobs = [(str(f), args.min_len, args.window, args.step) for f in files]
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        results = list(pool.map(_profile, jobs, chunksize=8))
+    elapsed = time.perf_counter() - start
+
+    profiles = {}
+    args.out.mkdir(parents=True, exist_ok=True)
+    entropy_rows, section_rows = [], []
+    with open(args.out / "strings.jsonl", "w") as strings_file:
+        for path, sections, error in results:
+            if error:
+                print(f" [Error] {path}: {error}")
+                continue
+            profiles[path] = sections
+            info = describe_binary(path, args.output_dir)
+            key = {"task": info["task"], "group": info["group"], "binary": info["binary"]}
+            strings_file.write(json.dumps({**key, "strings": {n: s["strings"] for n, s in sections.items()}}) + "\n")
+            for name, s in sections.items():
+                entropy_rows.extend({**key, "section": name, "offset": int(o), "entropy": round(float(e), 4)}
+                                    for o, e in zip(s["offsets"], s["entropy"]))
+                section_rows.append({**key, "section": name, "size": s["size"], "strings": len(s["strings"]),
+                                     "string_bytes": sum(len(x) for x in s["strings"]),
+                                     "mean_entropy": _mean_entropy(s),
+                                     "max_entropy": round(float(s["entropy"].max()), 4)})
+    _write_csv(args.out / "entropy.csv", entropy_rows, ["task", "group", "binary", "section", "offset", "entropy"])
+    _write_csv(args.out / "sections.csv", section_rows,
+               ["task", "group", "binary", "section", "size", "strings", "string_bytes", "mean_entropy",
+                "max_entropy"])
+    summary = elit_summary(profiles, args.output_dir)
+    if summary:
+        _write_csv(args.out / "elit_summary.csv", summary, list(summary[0]))
+
+    print(f"Done in {elapsed * 1000:.0f} ms: {sum(len(s) for s in profiles.values())} sections, "
+          f"{len(entropy_rows)} entropy windows")
+    if summary:
+        literals = sum(r["base_literals"] for r in summary)
+        removed = sum(r["removed"] for r in summary)
+        print(f"_elit removed {removed}/{literals} .rodata literals ({100 * removed / max(literals, 1):.1f}%) "
+              f"across {len(summary)} programs")
+    print(f"Profiles saved to: {args.out}/")
+
+
+if __name__ == "__main__":
+    main()
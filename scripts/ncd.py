@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Normalized Compression Distance (NCD) between binaries.
+
+    NCD(x, y) = (C(xy) - min(C(x), C(y))) / max(C(x), C(y))
+
+C is DEFLATE (LZ77 + Huffman) from the zlib module. Every binary is compressed
+once on its own; for a pair the compressor state left after feeding x is copied
+and only y is pushed through it, so x's LZ window acts as a primed dictionary
+and C(xy) costs one compression of y. The corpus binaries (~16-22 KB) fit in
+DEFLATE's 32 KB window, so all of x stays visible while y is compressed.
+Rows of the pair matrix are spread over worker processes.
+"""
+import argparse
+import csv
+import itertools
+import os
+import time
+import zlib
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+# zlib level 6 is ~8x faster than 9 with near-identical distances on the corpus
+COMPRESSION_LEVEL = 6
+
+
+def compressed_size(data, level=COMPRESSION_LEVEL):
+    """C(x): size of x compressed on its own."""
+    return len(zlib.compress(data, level))
+
+
+class PrimedCompressor:
+    """Compressor state after consuming x, reusable for any number of y."""
+
+    def __init__(self, data, level=COMPRESSION_LEVEL):
+        self._state = zlib.compressobj(level)
+        self._emitted = len(self._state.compress(data))
+
+    def joint_size(self, other):
+        """C(xy) without recompressing x."""
+        state = self._state.copy()
+        return self._emitted + len(state.compress(other)) + len(state.flush())
+
+
+def ncd(size_x, size_y, size_xy):
+    """Distance in [0, ~1.1]; the small overshoot above 1 is compressor slack."""
+    return (size_xy - min(size_x, size_y)) / max(size_x, size_y)
+
+
+def similarity(distance):
+    """Map NCD onto the 0-100 'higher is more similar' scale of the other tools."""
+    return round(max(0.0, min(1.0, 1.0 - distance)) * 100, 2)
+
+
+# Per-process file contents, loaded once by the pool initializer
+_DATA = []
+
+
+def _load(paths):
+    global _DATA
+    _DATA = [Path(p).read_bytes() for p in paths]
+
+
+def _row(args):
+    """Worker: NCD of file i against every later file j, sharing one primed state."""
+    i, sizes, level = args
+    primed = PrimedCompressor(_DATA[i], level)
+    return [(i, j, ncd(sizes[i], sizes[j], primed.joint_size(_DATA[j])))
+            for j in range(i + 1, len(_DATA))]
+
+
+def pairwise_ncd(paths, workers=None, level=COMPRESSION_LEVEL):
+    """
+    All-pairs NCD for a list of files.
+
+    Returns:
+        list: (i, j, distance) for every i < j.
+    """
+    paths = [str(p) for p in paths]
+    _load(paths)
+    sizes = [compressed_size(data, level) for data in _DATA]
+    jobs = [(i, sizes, level) for i in range(len(paths) - 1)]
+    if len(jobs) < 2 or workers == 1:
+        return list(itertools.chain.from_iterable(map(_row, jobs)))
+    with ProcessPoolExecutor(max_workers=workers, initializer=_load, initargs=(paths,)) as pool:
+        # Early rows are the longest; a small chunksize keeps the workers balanced
+        return list(itertools.chain.from_iterable(pool.map(_row, jobs, chunksize=4)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="All-pairs NCD over the binaries in output/")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    parser.add_argument("--csv", default="ncd_results.csv")
+    args = parser.parse_args()
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Computing NCD for {len(files)} binaries ({len(files) * (len(files) - 1) // 2} pairs)...")
+    start = time.perf_counter()
+    pairs = pairwise_ncd(files, workers=args.workers)
+    elapsed = time.perf_counter() - start
+    print(f"Done in {elapsed:.2f}s ({len(pairs) / max(elapsed, 1e-9):,.0f} pairs/s)")
+
+    with open(args.csv, "w", newline="") as csvfile:
+        writer = csv.writer(csvfile)
+        writer.writerow(["File1", "File2", "NCD", "Score"])
+        for i, j, dist in pairs:
+            writer.writerow([files[i].relative_to(args.output_dir), files[j].relative_to(args.output_dir),
+                             round(dist, 4), similarity(dist)])
+    print(f"Results saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+Hashed instruction n-gram features of every binary, as a memory-mappable CSR matrix.
+
+Each function (cfg.function_ranges, so stripped binaries work too) is decoded
+and every instruction reduced to its operand-free Insn.key(); n-grams for
+n = 1..4 that stay inside one function are hashed into 2**bits columns and
+counted. One row per binary:
+
+  <out>/indptr.npy   int32 (int64 past 2**31 counts), n_rows + 1
+  <out>/indices.npy  same dtype as indptr, column of every stored count (sorted per row)
+  <out>/data.npy     uint32, n-gram counts
+  <out>/rows.csv     row, task, group, origin, defense, binary, path
+  <out>/meta.json    shape, n-gram range, hash bits, token scheme
+
+The .npy files open with np.load(mmap_mode="r"), so load_features() hands a
+classifier a scipy CSR matrix without reading or parsing any ELF file; the
+index arrays share one dtype so scipy keeps the mappings instead of copying.
+Binaries are decoded in worker processes; rows are streamed to disk in input
+order so memory stays flat regardless of corpus size.
+"""
+import argparse
+import csv
+import json
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+import cfg
+import elf_utils
+from cfg_metrics import describe_binary
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+FEATURE_DIR = "ngram_features"
+NGRAM_RANGE = (1, 4)
+HASH_BITS = 20
+TOKEN_SCHEME = "insn-key-v1"   # bump when Insn.key() or token_id() changes
+ROW_COLUMNS = ["row", "task", "group", "origin", "defense", "binary", "path"]
+
+_MIX1 = np.uint64(0xBF58476D1CE4E5B9)
+_MIX2 = np.uint64(0x94D049BB133111EB)
+_PRIME = np.uint64(0x100000001B3)
+_GOLDEN = 0x9E3779B97F4A7C15
+
+
+def _salt(n):
+    """Per-n salt, defined for any n-gram length."""
+    return np.uint64(n * _GOLDEN & 0xFFFFFFFFFFFFFFFF)
+
+
+def token_id(insn):
+    """Pack Insn.key() (map, opcode, group, form, 0x66, REX.W) into one integer."""
+    map_, opcode, group, form, opsize, rex_w = insn.key()
+    form_id = {"": 0, "r": 1, "m": 2}[form]
+    return ((((map_ * 256 + opcode) * 9 + group + 1) * 3 + form_id) * 2 + opsize) * 2 + rex_w
+
+
+def _mix(h):
+    """splitmix64 finalizer over a uint64 array."""
+    h = (h ^ (h >> np.uint64(30))) * _MIX1
+    h = (h ^ (h >> np.uint64(27))) * _MIX2
+    return h ^ (h >> np.uint64(31))
+
+
+def binary_tokens(path):
+    """Token stream of a binary plus the function number of every token."""
+    elf = elf_utils.ELFFile(path)
+    tokens, owners = [], []
+    for number, (start, size, _) in enumerate(cfg.function_ranges(elf)):
+        ids = [token_id(insn) for insn in cfg.decode_range(elf, start, size)]
+        tokens.extend(ids)
+        owners.extend([number] * len(ids))
+    return np.array(tokens, dtype=np.uint64), np.array(owners, dtype=np.int64)
+
+
+def ngram_counts(tokens, owners, ngram_range=NGRAM_RANGE, bits=HASH_BITS):
+    """
+    Hashed n-gram histogram of one token stream.
+
+    Returns:
+        tuple: (columns uint32 sorted, counts uint32)
+    """
+    buckets = []
+    h = np.zeros(len(tokens), dtype=np.uint64)
+    for n in range(1, ngram_range[1] + 1):
+        width = len(tokens) - n + 1
+        if width <= 0:
+            break
+        # Rolling polynomial over tokens[i:i+n]; the per-n salt keeps an n-gram
+        # and its (n-1)-gram prefix from landing in correlated buckets
+        h = h[:width] * _PRIME + tokens[n - 1:n - 1 + width]
+        if n >= ngram_range[0]:
+            inside = owners[:width] == owners[n - 1:n - 1 + width]
+            mixed = _mix(h[inside] + _salt(n))
+            buckets.append((mixed >> np.uint64(64 - bits)).astype(np.uint32))
+    if not buckets:
+        return np.empty(0, dtype=np.uint32), np.empty(0, dtype=np.uint32)
+    columns, counts = np.unique(np.concatenate(buckets), return_counts=True)
+    return columns.astype(np.uint32), counts.astype(np.uint32)
+
+
+def _extract(args):
+    path, ngram_range, bits = args
+    try:
+        tokens, owners = binary_tokens(path)
+        columns, counts = ngram_counts(tokens, owners, ngram_range, bits)
+        return path, columns, counts, None
+    except (ValueError, IndexError, OSError) as e:
+        return path, np.empty(0, dtype=np.uint32), np.empty(0, dtype=np.uint32), str(e)
+
+
+def _finalize(raw_path, npy_path, raw_dtype, dtype):
+    """Turn a raw little-endian dump into a .npy file of dtype and remove the dump."""
+    count = raw_path.stat().st_size // np.dtype(raw_dtype).itemsize
+    out = np.lib.format.open_memmap(npy_path, mode="w+", dtype=dtype, shape=(count,))
+    if count:
+        out[:] = np.memmap(raw_path, dtype=raw_dtype, mode="r", shape=(count,))
+    out.flush()
+    del out
+    raw_path.unlink()
+
+
+def build_features(files, out_dir, output_dir=OUTPUT_DIR, ngram_range=NGRAM_RANGE, bits=HASH_BITS,
+                   workers=None):
+    """
+    Extract every binary in parallel and write the CSR files to out_dir.
+
+    Returns:
+        dict: {path: error} for binaries that could not be decoded (empty rows).
+    """
+    out_dir = Path(out_dir)
+    out_dir.mkdir(parents=True, exist_ok=True)
+    indices_raw = out_dir / "indices.u32"
+    data_raw = out_dir / "data.u32"
+    indptr = [0]
+    errors = {}
+    jobs = [(str(f), ngram_range, bits) for f in files]
+    with open(indices_raw, "wb") as fi, open(data_raw, "wb") as fd, \
+            open(out_dir / "rows.csv", "w", newline="") as rows_file, \
+            ProcessPoolExecutor(max_workers=workers) as pool:
+        writer = csv.DictWriter(rows_file, fieldnames=ROW_COLUMNS)
+        writer.writeheader()
+        for row, (path, columns, counts, error) in enumerate(pool.map(_extract, jobs, chunksize=4)):
+            if error:
+                errors[path] = error
+            fi.write(columns.astype("<u4").tobytes())
+            fd.write(counts.astype("<u4").tobytes())
+            indptr.append(indptr[-1] + len(columns))
+            info = describe_binary(path, output_dir)
+            writer.writerow({"row": row, "task": info["task"], "group": info["group"], "origin": info["origin"],
+                             "defense": info["defense"], "binary": info["binary"], "path": path})
+
+    index_dtype = np.int32 if indptr[-1] < 2**31 and bits < 31 else np.int64
+    _finalize(indices_raw, out_dir / "indices.npy", "<u4", index_dtype)
+    _finalize(data_raw, out_dir / "data.npy", "<u4", np.uint32)
+    np.save(out_dir / "indptr.npy", np.array(indptr, dtype=index_dtype))
+    with open(out_dir / "meta.json", "w") as f:
+        json.dump({
+            "shape": [len(indptr) - 1, 1 << bits],
+            "nnz": indptr[-1],
+            "ngram_range": list(ngram_range),
+            "hash_bits": bits,
+            "token_scheme": TOKEN_SCHEME,
+            "format": "csr",
+        }, f, indent=2)
+    return errors
+
+
+def load_features(feature_dir=FEATURE_DIR):
+    """
+    Memory-mapped CSR feature matrix and its row index.
+
+    Returns:
+        tuple: (scipy.sparse.csr_matrix, list of row dicts from rows.csv)
+    """
+    from scipy import sparse
+
+    feature_dir = Path(feature_dir)
+    with open(feature_dir / "meta.json") as f:
+        meta = json.load(f)
+    arrays = [np.load(feature_dir / f"{name}.npy", mmap_mode="r") for name in ("data", "indices", "indptr")]
+    matrix = sparse.csr_matrix(tuple(arrays), shape=tuple(meta["shape"]), copy=False)
+    with open(feature_dir / "rows.csv", newline="") as f:
+        rows = list(csv.DictReader(f))
+    return matrix, rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Hashed instruction n-gram CSR features for every binary")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--out", type=Path, default=Path(FEATURE_DIR), help="Feature directory to write")
+    # Column indices are uint32
+    parser.add_argument("--bits", type=int, default=HASH_BITS, choices=range(1, 33), metavar="{1..32}",
+                        help="log2 of the number of hash columns")
+    parser.add_argument("--max-n", type=int, default=NGRAM_RANGE[1])
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    files = sorted(p for p in args.output_dir.glob("*/*/*") if p.is_file())
+    print(f"Extracting n-grams (n=1..{args.max_n}, 2^{args.bits} columns) from {len(files)} binaries...")
+    start = time.perf_counter()
+    errors = build_features(files, args.out, args.output_dir, (NGRAM_RANGE[0], args.max_n), args.bits,
+                            args.workers)
+    elapsed = time.perf_counter() - start
+    for path, error in errors.items():
+        print(f" [Error] {path}: {error}")
+
+    matrix, rows = load_features(args.out)
+    print(f"Done in {elapsed:.2f}s: {matrix.shape[0]} rows, {matrix.nnz} stored counts "
+          f"({matrix.nnz / max(matrix.shape[0], 1):.0f} per binary)")
+    print(f"Features saved to: {args.out}/")
+
+
+if __name__ == "__main__":
+    main()
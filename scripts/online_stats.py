@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""
+Streaming statistics of the similarity scores while analyze_binaries.py runs.
+
+Every result row appended by the analyze_* functions is also folded into one
+cell per (Task, Variant, Group, Tool):
+
+  - Welford running count / mean / variance, plus min and max
+  - a merging t-digest (compression 100) for the median and other quantiles
+  - a fixed 0.5-wide histogram over the 0-100 scale, a rank sketch: the
+    position of any score within a cell, and Mann-Whitney U between two
+    cells with bins as tie groups (exact for the integer-valued ssdeep and
+    sdhash scores)
+
+Scores go through result_store.convert_score and radiff2's 0-1 similarity is
+put on the 0-100 scale, as analyze_csv.py does, so the numbers match the
+final tables. Every few seconds the cells are written to live_summary.csv
+and their state to online_stats.json, both replaced atomically, so a long
+campaign can be watched while it runs and the summary is ready when it
+ends. Cells merge exactly (Welford, histogram) or within the t-digest error,
+so any coarser grouping can be printed from the state:
+
+  online_stats.py [--state online_stats.json] [--by Group Variant Tool]
+"""
+import argparse
+import csv
+import json
+import math
+import os
+import time
+from pathlib import Path
+
+import numpy as np
+
+from result_store import convert_score
+
+# --- Configuration ---
+KEYS = ["Task", "Variant", "Group", "Tool"]
+STATE_FILE = "online_stats.json"
+LIVE_CSV = "live_summary.csv"
+LIVE_INTERVAL = 5.0
+COMPRESSION = 100
+QUANTILES = [0.25, 0.5, 0.75]
+HISTOGRAM_BINS = 201        # [0, 0.5), ..., [99.5, 100), and 100 itself
+HISTOGRAM_WIDTH = 0.5
+# Tools whose raw scores are rescaled to 0-100 (same as analyze_csv.py)
+SCORE_SCALE = {"radiff2": 100}
+
+
+class Welford:
+    """Running count, mean, variance, min and max."""
+
+    def __init__(self, count=0, mean=0.0, m2=0.0, low=math.inf, high=-math.inf):
+        self.count, self.mean, self.m2, self.low, self.high = count, mean, m2, low, high
+
+    def add(self, x):
+        self.count += 1
+        delta = x - self.mean
+        self.mean += delta / self.count
+        self.m2 += delta * (x - self.mean)
+        self.low = min(self.low, x)
+        self.high = max(self.high, x)
+
+    def merge(self, other):
+        if other.count == 0:
+            return
+        total = self.count + other.count
+        delta = other.mean - self.mean
+        self.mean += delta * other.count / total
+        self.m2 += other.m2 + delta * delta * self.count * other.count / total
+        self.count = total
+        self.low, self.high = min(self.low, other.low), max(self.high, other.high)
+
+    @property
+    def std(self):
+        """Sample standard deviation (ddof=1), NaN below two values."""
+        return math.sqrt(self.m2 / (self.count - 1)) if self.count > 1 else math.nan
+
+
+class TDigest:
+    """Merging t-digest with the k1 (arcsine) scale function."""
+
+    def __init__(self, compression=COMPRESSION, means=(), weights=()):
+        self.compression = compression
+        self.means = np.asarray(means, dtype=np.float64)
+        self.weights = np.asarray(weights, dtype=np.float64)
+        self._buffer = []
+
+    def add(self, x):
+        self._buffer.append(x)
+        if len(self._buffer) >= 5 * self.compression:
+            self._compress()
+
+    def merge(self, other):
+        other._compress()
+        self._compress()
+        self.means = np.concatenate([self.means, other.means])
+        self.weights = np.concatenate([self.weights, other.weights])
+        self._compress(force=True)
+
+    def _compress(self, force=False):
+        if not self._buffer and not force:
+            return
+        means = np.concatenate([self.means, self._buffer])
+        weights = np.concatenate([self.weights, np.ones(len(self._buffer))])
+        self._buffer = []
+        if len(means) == 0:
+            return
+        order = np.argsort(means, kind="stable")
+        means, weights = means[order], weights[order]
+        total = weights.sum()
+        scale = self.compression / (2 * math.pi)
+
+        def q_limit(q):
+            # Largest quantile reachable from q within one unit of k
+            k = scale * math.asin(2 * min(max(q, 0.0), 1.0) - 1) + 1
+            return 1.0 if k >= scale * math.pi / 2 else (math.sin(k / scale) + 1) / 2
+
+        out_means, out_weights = [], []
+        done = 0.0
+        mean, weight = means[0], weights[0]
+        limit = q_limit(0.0)
+        for m, w in zip(means[1:].tolist(), weights[1:].tolist()):
+            if (done + weight + w) / total <= limit:
+                weight += w
+                mean += (m - mean) * w / weight
+            else:
+                out_means.append(mean)
+                out_weights.append(weight)
+                done += weight
+                limit = q_limit(done / total)
+                mean, weight = m, w
+        out_means.append(mean)
+        out_weights.append(weight)
+        self.means, self.weights = np.array(out_means), np.array(out_weights)
+
+    def quantile(self, q, low, high):
+        """Estimated q-quantile; low/high are the exact min and max."""
+        self._compress()
+        if len(self.means) == 0:
+            return math.nan
+        if len(self.means) == 1:
+            return float(self.means[0])
+        # Centroid centers sit at the middle of their weight
+        centers = np.cumsum(self.weights) - self.weights / 2
+        position = q * self.weights.sum()
+        return float(np.interp(position, np.concatenate([[0], centers, [self.weights.sum()]]),
+                               np.concatenate([[low], self.means, [high]])))
+
+    def state(self):
+        self._compress()
+        return {"means": self.means.tolist(), "weights": self.weights.tolist()}
+
+
+class Histogram:
+    """Counts of scores in 0.5-wide bins over 0-100 (values outside are clamped)."""
+
+    def __init__(self, counts=None):
+        self.counts = np.zeros(HISTOGRAM_BINS, dtype=np.int64) if counts is None else np.asarray(counts, dtype=np.int64)
+
+    def add(self, x):
+        self.counts[min(max(int(x / HISTOGRAM_WIDTH), 0), HISTOGRAM_BINS - 1)] += 1
+
+    def merge(self, other):
+        self.counts += other.counts
+
+    def rank_fraction(self, x):
+        """Share of the cell below x, counting its own bin half (mid-rank)."""
+        total = self.counts.sum()
+        if total == 0:
+            return math.nan
+        b = min(max(int(x / HISTOGRAM_WIDTH), 0), HISTOGRAM_BINS - 1)
+        return (self.counts[:b].sum() + self.counts[b] / 2) / total
+
+    def mann_whitney_u(self, other):
+        """U of this cell against another, with every bin as one tie group."""
+        below = np.cumsum(other.counts) - other.counts
+        return float((self.counts * (below + 0.5 * other.counts)).sum())
+
+
+class Cell:
+    """Streaming statistics of one (Task, Variant, Group, Tool)."""
+
+    def __init__(self, state=None):
+        state = state or {}
+        self.moments = Welford(**state.get("moments", {}))
+        self.digest = TDigest(**state.get("digest", {}))
+        self.histogram = Histogram(state.get("histogram"))
+
+    def add(self, x):
+        self.moments.add(x)
+        self.digest.add(x)
+        self.histogram.add(x)
+
+    def merge(self, other):
+        self.moments.merge(other.moments)
+        self.digest.merge(other.digest)
+        self.histogram.merge(other.histogram)
+
+    def summary(self):
+        m = self.moments
+        row = {"count": m.count, "mean": m.mean if m.count else math.nan, "std": m.std,
+               "min": m.low if m.count else math.nan, "max": m.high if m.count else math.nan}
+        for q in QUANTILES:
+            row[f"q{int(q * 100)}"] = self.digest.quantile(q, m.low, m.high)
+        return row
+
+    def state(self):
+        m = self.moments
+        return {"moments": {"count": m.count, "mean": m.mean, "m2": m.m2,
+                            "low": m.low if m.count else None, "high": m.high if m.count else None},
+                "digest": self.digest.state(),
+                "histogram": self.histogram.counts.tolist()}
+
+
+class OnlineAggregator:
+    """Cells keyed by (Task, Variant, Group, Tool), with periodic live output."""
+
+    def __init__(self, state_path=STATE_FILE, live_csv=LIVE_CSV, interval=LIVE_INTERVAL):
+        self.cells = {}
+        self.rows = 0
+        self.state_path, self.live_csv, self.interval = state_path, live_csv, interval
+        self._started = self._flushed = time.perf_counter()
+
+    def add(self, row):
+        score = convert_score(row["Score"]) * SCORE_SCALE.get(row["Tool"], 1)
+        key = tuple(str(row[k]) for k in KEYS)
+        cell = self.cells.get(key)
+        if cell is None:
+            cell = self.cells[key] = Cell()
+        cell.add(score)
+        self.rows += 1
+        if self.interval is not None and time.perf_counter() - self._flushed >= self.interval:
+            self.flush()
+
+    def grouped(self, by=KEYS):
+        """Cells merged over the keys not in by, sorted by key."""
+        index = [KEYS.index(k) for k in by]
+        merged = {}
+        for key, cell in self.cells.items():
+            target = merged.setdefault(tuple(key[i] for i in index), Cell())
+            target.merge(cell)
+        return dict(sorted(merged.items()))
+
+    def summary_rows(self, by=KEYS):
+        return [{**dict(zip(by, key)), **cell.summary()} for key, cell in self.grouped(by).items()]
+
+    def flush(self, verbose=True):
+        """Write live_summary.csv and the state file, each replaced atomically."""
+        rows = self.summary_rows()
+        if self.live_csv and rows:
+            tmp = f"{self.live_csv}.tmp"
+            with open(tmp, "w", newline="") as f:
+                writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+                writer.writeheader()
+                writer.writerows(rows)
+            os.replace(tmp, self.live_csv)
+        if self.state_path:
+            tmp = f"{self.state_path}.tmp"
+            with open(tmp, "w") as f:
+                json.dump({"rows": self.rows,
+                           "cells": [{"key": list(key), **cell.state()} for key, cell in self.cells.items()]}, f)
+            os.replace(tmp, self.state_path)
+        self._flushed = time.perf_counter()
+        if verbose:
+            print(f" [online] {self.rows} scores in {len(self.cells)} cells "
+                  f"after {self._flushed - self._started:.0f}s -> {self.live_csv}")
+
+    @classmethod
+    def load(cls, path):
+        with open(path) as f:
+            state = json.load(f)
+        aggregator = cls(state_path=None, live_csv=None, interval=None)
+        aggregator.rows = state["rows"]
+        for entry in state["cells"]:
+            moments = entry["moments"]
+            moments["low"] = math.inf if moments["low"] is None else moments["low"]
+            moments["high"] = -math.inf if moments["high"] is None else moments["high"]
+            aggregator.cells[tuple(entry["key"])] = Cell(entry)
+        return aggregator
+
+
+class StreamingResults(list):
+    """The results list of analyze_binaries.py, feeding an aggregator on every append."""
+
+    def __init__(self, aggregator):
+        super().__init__()
+        self.aggregator = aggregator
+
+    def append(self, row):
+        super().append(row)
+        self.aggregator.add(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Summary of the streaming statistics of an analysis run")
+    parser.add_argument("--state", type=Path, default=Path(STATE_FILE))
+    parser.add_argument("--by", nargs="+", default=KEYS, choices=KEYS, help="Keys to keep (others are merged)")
+    args = parser.parse_args()
+    if not args.state.is_file():
+        print(f" [Error] {args.state} not found; it is written while analyze_binaries.py runs.")
+        return
+    aggregator = OnlineAggregator.load(args.state)
+    rows = aggregator.summary_rows(args.by)
+    print(f"{args.state}: {aggregator.rows} scores, {len(aggregator.cells)} cells")
+    header = args.by + list(rows[0])[len(args.by):] if rows else args.by
+    print("  ".join(f"{h:>12}" for h in header))
+    for row in rows:
+        print("  ".join(f"{row[h]:>12.3f}" if isinstance(row[h], float) else f"{row[h]:>12}" for h in header))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,127 @@
+"""
+Exact Mann-Whitney U for many subgroups from one radix sort.
+
+Scores are turned into order-preserving unsigned integer keys (the float bit
+pattern with negatives inverted) and sorted by (subgroup, key) with an LSD
+radix sort: one stable pass per 16-bit digit, two for float32 scores and
+four for float64, then one by subgroup code. numpy's stable sort is itself a
+radix sort on 16-bit integers, so every pass is linear. In the sorted order
+runs of equal (subgroup, key) are the tie groups; each gets the mid-rank of
+its positions within the subgroup, and per-subgroup rank sums of the first
+sample and tie terms sum(t^3 - t) fall out of bincounts.
+
+From those, per subgroup, as scipy.stats.mannwhitneyu(x, y) with its
+defaults (two-sided, continuity correction, asymptotic method):
+
+    U1 = R1 - n1 (n1 + 1) / 2
+    z  = (max(U1, U2) - n1 n2 / 2 - 0.5) / sigma,
+         sigma^2 = n1 n2 / 12 * ((n + 1) - sum(t^3 - t) / (n (n - 1)))
+    p  = min(1, 2 * sf(z))
+    rank-biserial = 1 - 2 U1 / (n1 n2), as in analyze_csv.py
+
+scipy switches to its exact distribution when either sample has at most 8
+values and there are no ties; those (rare) subgroups are handed to scipy so
+p stays identical.
+"""
+import numpy as np
+from scipy import stats
+
+# --- Configuration ---
+DIGIT_BITS = 16
+# Up to this size in either sample (and without ties) scipy uses the exact distribution
+EXACT_SIZE = 8
+
+
+def _sort_keys(scores):
+    """Unsigned integer keys ordered like the float scores."""
+    scores = np.ascontiguousarray(scores)
+    if scores.dtype not in (np.float32, np.float64):
+        scores = scores.astype(np.float64)
+    # -0.0 and 0.0 must share a key
+    scores = scores + scores.dtype.type(0)
+    unsigned = np.uint32 if scores.dtype == np.float32 else np.uint64
+    bits = scores.view(unsigned)
+    sign = unsigned(1) << unsigned(8 * scores.itemsize - 1)
+    return np.where(bits & sign, ~bits, bits | sign)
+
+
+def radix_order(keys, subgroups=None):
+    """Stable order sorting rows by (subgroup, key) with 16-bit LSD passes."""
+    order = np.arange(len(keys))
+    mask = keys.dtype.type((1 << DIGIT_BITS) - 1)
+    for shift in range(0, 8 * keys.dtype.itemsize, DIGIT_BITS):
+        digit = ((keys[order] >> keys.dtype.type(shift)) & mask).astype(np.uint16)
+        order = order[np.argsort(digit, kind="stable")]
+    if subgroups is not None:
+        order = order[np.argsort(subgroups[order], kind="stable")]
+    return order
+
+
+def mann_whitney(scores, sample, subgroups=None, n_subgroups=None):
+    """
+    Mann-Whitney U test of sample 1 against sample 0 within every subgroup.
+
+    Args:
+        scores: float scores (float32 keeps the sort at two passes)
+        sample: per row 1 (first sample), 0 (second sample) or -1 (ignored)
+        subgroups: optional per row subgroup code 0..n_subgroups-1
+        n_subgroups: number of subgroups (default: max code + 1)
+
+    Returns:
+        dict: arrays over subgroups of n1, n2, u (U of sample 1), z, p and rbc;
+        NaN where a sample is empty
+    """
+    scores = np.asarray(scores)
+    sample = np.asarray(sample)
+    keep = (sample >= 0) & ~np.isnan(scores)
+    if subgroups is None:
+        subgroups = np.zeros(len(scores), dtype=np.uint16)
+    subgroups = np.asarray(subgroups)
+    if n_subgroups is None:
+        n_subgroups = int(subgroups[keep].max()) + 1 if keep.any() else 0
+    code_type = np.uint16 if n_subgroups <= 1 << 16 else np.uint32
+    scores, first, groups = scores[keep], sample[keep] == 1, subgroups[keep].astype(code_type)
+
+    keys = _sort_keys(scores)
+    order = radix_order(keys, groups)
+    keys, first, groups = keys[order], first[order], groups[order]
+
+    n = np.bincount(groups, minlength=n_subgroups)
+    n1 = np.bincount(groups, weights=first, minlength=n_subgroups)
+    n2 = n - n1
+    group_start = np.concatenate(([0], np.cumsum(n)[:-1]))
+
+    # Tie groups: runs of equal (subgroup, key)
+    boundary = np.ones(len(keys), dtype=bool)
+    boundary[1:] = (keys[1:] != keys[:-1]) | (groups[1:] != groups[:-1])
+    run_first = np.flatnonzero(boundary)
+    run_length = np.diff(np.append(run_first, len(keys)))
+    run_of = np.cumsum(boundary) - 1
+    run_group = groups[run_first]
+    # 1-based mid-rank of every run within its subgroup
+    run_rank = run_first - group_start[run_group] + (run_length + 1) / 2
+    r1 = np.bincount(groups, weights=run_rank[run_of] * first, minlength=n_subgroups)
+    t = run_length.astype(np.float64)
+    tie_term = np.bincount(run_group, weights=t ** 3 - t, minlength=n_subgroups)
+
+    with np.errstate(divide="ignore", invalid="ignore"):
+        u1 = r1 - n1 * (n1 + 1) / 2
+        u2 = n1 * n2 - u1
+        mu = n1 * n2 / 2
+        sigma = np.sqrt(n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1))))
+        z = (np.maximum(u1, u2) - mu - 0.5) / sigma
+        p = np.clip(2 * stats.norm.sf(z), 0, 1)
+        rbc = 1 - 2 * u1 / (n1 * n2)
+    empty = (n1 == 0) | (n2 == 0)
+    for array in (u1, z, p, rbc):
+        array[empty] = np.nan
+
+    # Subgroups scipy would test exactly
+    exact = np.flatnonzero(~empty & ((n1 <= EXACT_SIZE) | (n2 <= EXACT_SIZE)) & (tie_term == 0))
+    for g in exact:
+        rows = slice(group_start[g], group_start[g] + n[g])
+        values = scores[order][rows]
+        result = stats.mannwhitneyu(values[first[rows]], values[~first[rows]], alternative="two-sided")
+        p[g] = result.pvalue
+        z[g] = np.nan
+    return {"n1": n1.astype(np.int64), "n2": n2.astype(np.int64), "u": u1, "z": z, "p": p, "rbc": rbc}
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""
+Columnar, memory-mappable store of the pairwise comparison results.
+
+analyze_binaries.py writes analysis_results.col instead of a CSV in which
+every score is a string and Task/Variant/Group/Tool/File1/File2 are repeated
+on each row. The file is
+
+    magic (8 bytes) | header length (uint64) | JSON header | columns
+
+where every column starts on a 64-byte boundary. String columns are
+dictionary-encoded: the header lists the distinct values in order of first
+appearance and the column holds their codes in the smallest unsigned integer
+type that fits. Score is float32, parsed once at write time (leading zeros of
+ssdeep's "016" stripped). Anything unparsable, a failed comparison's "N/A",
+is stored as NaN so it stays distinct from a real 0 score; readers see the
+0.0 analyze_csv.py has always used for it, and missing() marks those rows.
+The header also records the most decimal places any input score had; when
+float32 is precise enough at that scale, readers round back to it, so the
+float64 scores handed to pandas are the same doubles the CSV parser produced
+and the tables do not move in their last digit.
+
+ResultTable maps a file read-only, so opening it costs the header parse and
+filters are comparisons on integer codes. CSV files are accepted everywhere
+a table is read and converted on the fly.
+
+Commands:
+  convert CSV [-o OUT]   write the columnar form of an analysis_results.csv
+  to-csv COL [-o OUT]    write a columnar file back out as CSV (missing scores as N/A)
+  info COL               row count, column types and dictionary sizes
+"""
+import argparse
+import csv
+import json
+import struct
+import time
+from pathlib import Path
+
+import numpy as np
+import pandas as pd
+
+# --- Configuration ---
+MAGIC = b"MTDRES1\0"
+ALIGN = 64
+CATEGORY_COLUMNS = ["Task", "Variant", "Group", "Tool", "File1", "File2"]
+SCORE_COLUMN = "Score"
+COLUMNS = CATEGORY_COLUMNS + [SCORE_COLUMN]
+RESULTS_FILE = "analysis_results.col"
+
+
+def parse_score(score):
+    """Score value as a float: "016" -> 16.0, unparsable -> NaN."""
+    try:
+        if isinstance(score, str) and score.startswith("0"):
+            return float(score.lstrip("0")) if score.lstrip("0") else 0.0
+        return float(score)
+    except (TypeError, ValueError):
+        return float("nan")
+
+
+def convert_score(score):
+    """Score value as a float: "016" -> 16.0, unparsable -> 0.0."""
+    score = parse_score(score)
+    return 0.0 if np.isnan(score) else score
+
+
+def _decimals(score):
+    """Decimal places of a score as written, or None for exponent notation."""
+    text = str(score).strip()
+    if "e" in text.lower():
+        return None
+    return len(text) - text.index(".") - 1 if "." in text else 0
+
+
+def _code_dtype(size):
+    for dtype in (np.uint8, np.uint16, np.uint32):
+        if size <= np.iinfo(dtype).max + 1:
+            return np.dtype(dtype)
+    return np.dtype(np.uint64)
+
+
+def write(path, rows):
+    """
+    Write result rows (dicts with the COLUMNS keys) as a columnar file.
+
+    Returns:
+        int: number of rows written
+    """
+    dictionaries = {name: {} for name in CATEGORY_COLUMNS}
+    codes = {name: [] for name in CATEGORY_COLUMNS}
+    scores = []
+    decimals = 0
+    for row in rows:
+        for name in CATEGORY_COLUMNS:
+            values = dictionaries[name]
+            value = str(row[name])
+            code = values.get(value)
+            if code is None:
+                code = values[value] = len(values)
+            codes[name].append(code)
+        scores.append(parse_score(row[SCORE_COLUMN]))
+        if decimals is not None and not np.isnan(scores[-1]):
+            places = _decimals(row[SCORE_COLUMN])
+            decimals = None if places is None else max(decimals, places)
+
+    arrays = {name: np.array(codes[name], dtype=_code_dtype(len(dictionaries[name]))) for name in CATEGORY_COLUMNS}
+    arrays[SCORE_COLUMN] = np.array(scores, dtype=np.float32)
+    columns = []
+    offset = 0
+    for name in COLUMNS:
+        column = {"name": name, "dtype": arrays[name].dtype.str, "offset": offset}
+        if name in dictionaries:
+            column["categories"] = list(dictionaries[name])
+        columns.append(column)
+        offset += -(-arrays[name].nbytes // ALIGN) * ALIGN
+    # Rounding recovers the input decimals only while float32 resolves them
+    if decimals is not None and np.nanmax(np.abs(scores), initial=0.0) * 10 ** decimals >= 2 ** 23:
+        decimals = None
+    header = json.dumps({"rows": len(scores), "score_decimals": decimals, "columns": columns}).encode()
+    # Column offsets are relative to the first aligned byte after the header
+    data_start = -(-(len(MAGIC) + 8 + len(header)) // ALIGN) * ALIGN
+
+    with open(path, "wb") as f:
+        f.write(MAGIC + struct.pack("<Q", len(header)) + header)
+        f.write(b"\0" * (data_start - f.tell()))
+        for name, column in zip(COLUMNS, columns):
+            f.seek(data_start + column["offset"])
+            f.write(arrays[name].tobytes())
+        f.truncate(data_start + offset)
+    return len(scores)
+
+
+def _read_csv_rows(path):
+    with open(path, newline="") as f:
+        yield from csv.DictReader(f)
+
+
+class ResultTable:
+    """Read-only view of a columnar results file (or of a CSV converted in memory)."""
+
+    def __init__(self, path):
+        path = Path(path)
+        if path.suffix == ".csv":
+            self._load_csv(path)
+            return
+        self._data = np.memmap(path, dtype=np.uint8, mode="r")
+        if bytes(self._data[:len(MAGIC)]) != MAGIC:
+            raise ValueError(f"{path} is not a columnar results file")
+        (length,) = struct.unpack("<Q", bytes(self._data[len(MAGIC):len(MAGIC) + 8]))
+        header = json.loads(bytes(self._data[len(MAGIC) + 8:len(MAGIC) + 8 + length]))
+        data_start = -(-(len(MAGIC) + 8 + length) // ALIGN) * ALIGN
+        self.rows = header["rows"]
+        self.score_decimals = header.get("score_decimals")
+        self._columns, self._categories = {}, {}
+        for column in header["columns"]:
+            dtype = np.dtype(column["dtype"])
+            start = data_start + column["offset"]
+            self._columns[column["name"]] = self._data[start:start + self.rows * dtype.itemsize].view(dtype)
+            if "categories" in column:
+                self._categories[column["name"]] = np.array(column["categories"], dtype=object)
+
+    def _load_csv(self, path):
+        rows = list(_read_csv_rows(path))
+        self.rows = len(rows)
+        # Scores stay float64 here; there is nothing to recover
+        self.score_decimals = None
+        self._columns, self._categories = {}, {}
+        for name in CATEGORY_COLUMNS:
+            values, codes = {}, np.empty(len(rows), dtype=np.uint32)
+            for i, row in enumerate(rows):
+                codes[i] = values.setdefault(row[name], len(values))
+            self._columns[name] = codes.astype(_code_dtype(len(values)))
+            self._categories[name] = np.array(list(values), dtype=object)
+        self._columns[SCORE_COLUMN] = np.array([parse_score(r[SCORE_COLUMN]) for r in rows])
+
+    def __len__(self):
+        return self.rows
+
+    def missing(self):
+        """Boolean mask of the rows whose score could not be parsed."""
+        return np.isnan(self._columns[SCORE_COLUMN])
+
+    @property
+    def scores(self):
+        """Score column as stored (float32; float64 for a CSV read directly), missing scores as 0.0."""
+        scores = self._columns[SCORE_COLUMN]
+        missing = self.missing()
+        return np.where(missing, scores.dtype.type(0), scores) if missing.any() else scores
+
+    def scores64(self):
+        """Score column as float64, rounded back to the input decimals when they are known."""
+        scores = self.scores.astype(np.float64)
+        if self.score_decimals is not None:
+            scale = 10.0 ** self.score_decimals
+            scores = np.rint(scores * scale) / scale
+        return scores
+
+    def codes(self, name):
+        """Integer codes of a dictionary-encoded column."""
+        return self._columns[name]
+
+    def categories(self, name):
+        """Distinct values of a dictionary-encoded column, indexed by code."""
+        return self._categories[name]
+
+    def code_of(self, name, value):
+        """Code of one value of a column, or -1 when it does not occur."""
+        hits = np.flatnonzero(self._categories[name] == value)
+        return int(hits[0]) if len(hits) else -1
+
+    def mask(self, **equals):
+        """Boolean row mask of column == value (or in a list of values) for every keyword."""
+        mask = np.ones(self.rows, dtype=bool)
+        for name, wanted in equals.items():
+            wanted = wanted if isinstance(wanted, (list, tuple, set)) else [wanted]
+            codes = [c for c in (self.code_of(name, v) for v in wanted) if c >= 0]
+            mask &= np.isin(self._columns[name], codes)
+        return mask
+
+    def column(self, name):
+        """Decoded values of a column (strings for categories, float32 for Score)."""
+        if name in self._categories:
+            return self._categories[name][self._columns[name]]
+        return self.scores
+
+    def to_dataframe(self):
+        """The table as the DataFrame analyze_csv.py works on (string columns, float64 Score)."""
+        frame = {name: self.column(name) for name in CATEGORY_COLUMNS}
+        frame[SCORE_COLUMN] = self.scores64()
+        return pd.DataFrame(frame, columns=COLUMNS)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Columnar store of pairwise similarity results")
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("convert")
+    p.add_argument("csv", type=Path)
+    p.add_argument("-o", "--output", type=Path, default=None)
+    p = sub.add_parser("to-csv")
+    p.add_argument("table", type=Path)
+    p.add_argument("-o", "--output", type=Path, default=None)
+    p = sub.add_parser("info")
+    p.add_argument("table", type=Path)
+    args = parser.parse_args()
+
+    if args.command == "convert":
+        output = args.output or args.csv.with_suffix(".col")
+        start = time.perf_counter()
+        count = write(output, _read_csv_rows(args.csv))
+        elapsed = time.perf_counter() - start
+        print(f"{args.csv} -> {output}: {count} rows in {elapsed * 1000:.0f} ms "
+              f"({args.csv.stat().st_size:,} -> {output.stat().st_size:,} bytes)")
+
+    elif args.command == "to-csv":
+        table = ResultTable(args.table)
+        output = args.output or args.table.with_suffix(".csv")
+        columns = [table.column(name) for name in CATEGORY_COLUMNS]
+        scores = ["N/A" if missing else int(score) if score.is_integer() else score
+                  for score, missing in zip(table.scores64().tolist(), table.missing().tolist())]
+        with open(output, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(COLUMNS)
+            writer.writerows(zip(*columns, scores))
+        print(f"{args.table} -> {output}: {len(table)} rows")
+
+    elif args.command == "info":
+        start = time.perf_counter()
+        table = ResultTable(args.table)
+        elapsed = time.perf_counter() - start
+        print(f"{args.table}: {len(table)} rows, opened in {elapsed * 1000:.2f} ms")
+        for name in CATEGORY_COLUMNS:
+            print(f"  {name:<8} {table.codes(name).dtype}  {len(table.categories(name))} values")
+        print(f"  {SCORE_COLUMN:<8} {table.scores.dtype}, {table.score_decimals} decimals, "
+              f"{int(table.missing().sum())} missing")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,365 @@
+#!/usr/bin/env python3
+"""
+Precomputed aggregate cube of the similarity scores with a slicing CLI.
+
+The cube has one axis per Task, Variant, Group and Tool, each with one
+extra ALL member at the end, so every rollup (any dimension aggregated away)
+is already a cell: a query is array indexing, not a pass over the results.
+Each cell holds count, mean and M2 (sum of squared deviations), merged with
+the exact parallel formula of online_stats.Welford so the two modules agree,
+min, max and a 0.5-wide score histogram (the online_stats.py layout) with the
+score sum of every bin. The median is the mean of the two middle order
+statistics, each located in the histogram and taken as the mean score of its
+bin: exact when the bin holds a single distinct value (always for the integer
+ssdeep and sdhash scores), within the 0.5 bin width otherwise. Several
+members of one dimension (dice) are merged the same way as rollups. Scores
+are on the 0-100 scale of analyze_csv.py (radiff2 x 100).
+
+Updates are incremental: `add` scans only the new results file, adds its
+rows to the base cells (growing an axis for new tasks, tools, ...) and
+refreshes the ALL members from the base cells, whose size does not depend on
+the number of rows. The results files the cube was built from are recorded
+by resolved path with their sha256: adding the same path or the same bytes
+again is skipped, and a recorded path whose contents changed (a rewritten
+analysis_results.col) is refused, since its old rows cannot be taken back
+out; rebuild the cube then. `drill` lists the underlying pair rows of a slice
+from the recorded files through result_store.ResultTable, skipping any whose
+hash no longer matches.
+
+Commands:
+  build [RESULTS...]       new cube (default: analysis_results.col)
+  add RESULTS...           fold new results files into the cube
+  query [--task T] [--variant V] [--group G] [--tool X] [--by DIM...]
+  drill [filters] [--limit N]
+Member names may be abbreviated to a unique prefix (--task T4).
+"""
+import argparse
+import hashlib
+import itertools
+import json
+import time
+from pathlib import Path
+
+import numpy as np
+
+import result_store
+from online_stats import HISTOGRAM_BINS, HISTOGRAM_WIDTH, SCORE_SCALE
+
+# --- Configuration ---
+DIMS = ["Task", "Variant", "Group", "Tool"]
+CUBE_FILE = "score_cube.npz"
+ALL = "*"
+
+
+def _combine(count, mean, m2, axis):
+    """Welford (count, mean, M2) of cells merged along axes, kept as size-1 dims."""
+    n = count.sum(axis=axis, keepdims=True)
+    with np.errstate(invalid="ignore", divide="ignore"):
+        merged = np.where(n > 0, (count * mean).sum(axis=axis, keepdims=True) / n, 0.0)
+    # Chan et al.: M2 = sum(M2_i) + sum(n_i (mean_i - mean)^2), Welford.merge applied k-way
+    return n, merged, (m2 + count * (mean - merged) ** 2).sum(axis=axis, keepdims=True)
+
+
+def _sha256(path):
+    with open(path, "rb") as f:
+        return hashlib.file_digest(f, "sha256").hexdigest()
+
+
+class ScoreCube:
+    """Dense cube of per-cell score aggregates with ALL members precomputed."""
+
+    def __init__(self, members=None, count=None, mean=None, m2=None, low=None, high=None,
+                 histogram=None, bin_total=None, sources=None):
+        self.members = members or {d: [] for d in DIMS}
+        shape = tuple(len(self.members[d]) + 1 for d in DIMS)
+        self.count = np.zeros(shape, dtype=np.int64) if count is None else count
+        self.mean = np.zeros(shape) if mean is None else mean
+        self.m2 = np.zeros(shape) if m2 is None else m2
+        self.low = np.full(shape, np.inf) if low is None else low
+        self.high = np.full(shape, -np.inf) if high is None else high
+        self.histogram = np.zeros(shape + (HISTOGRAM_BINS,), dtype=np.int64) if histogram is None else histogram
+        self.bin_total = np.zeros(shape + (HISTOGRAM_BINS,)) if bin_total is None else bin_total
+        self.sources = sources or []
+        self._index = {d: {m: i for i, m in enumerate(self.members[d])} for d in DIMS}
+
+    # --- Storage ---
+
+    def save(self, path):
+        meta = json.dumps({"members": self.members, "sources": self.sources})
+        with open(path, "wb") as f:
+            np.savez(f, meta=np.array(meta), count=self.count, mean=self.mean, m2=self.m2,
+                     low=self.low, high=self.high, histogram=self.histogram, bin_total=self.bin_total)
+
+    @classmethod
+    def load(cls, path):
+        with np.load(path, allow_pickle=False) as data:
+            meta = json.loads(str(data["meta"]))
+            return cls(meta["members"], data["count"], data["mean"], data["m2"], data["low"],
+                       data["high"], data["histogram"], data["bin_total"], meta["sources"])
+
+    # --- Updates ---
+
+    def _grow(self, dim, values):
+        """Add new members to one axis, in front of its ALL member."""
+        new = [v for v in dict.fromkeys(values) if v not in self._index[dim]]
+        if not new:
+            return
+        axis = DIMS.index(dim)
+        at = len(self.members[dim])
+        for name, fill in (("count", 0), ("mean", 0.0), ("m2", 0.0), ("low", np.inf),
+                           ("high", -np.inf), ("histogram", 0), ("bin_total", 0.0)):
+            array = getattr(self, name)
+            setattr(self, name, np.insert(array, [at] * len(new), fill, axis=axis))
+        for v in new:
+            self._index[dim][v] = len(self.members[dim])
+            self.members[dim].append(v)
+
+    def add_table(self, table):
+        """Add every row of a result_store.ResultTable to the base cells, then refresh the rollups."""
+        for d in DIMS:
+            self._grow(d, table.categories(d).tolist())
+        base_shape = tuple(len(self.members[d]) for d in DIMS)
+        index = [np.array([self._index[d][v] for v in table.categories(d)], dtype=np.int64)[table.codes(d)]
+                 for d in DIMS]
+        flat = np.ravel_multi_index(index, base_shape)
+        scale = np.array([SCORE_SCALE.get(t, 1) for t in table.categories("Tool")], dtype=np.float64)
+        scores = table.scores64() * scale[table.codes("Tool")]
+        bins = np.clip((scores / HISTOGRAM_WIDTH).astype(np.int64), 0, HISTOGRAM_BINS - 1)
+
+        cells = int(np.prod(base_shape))
+        base = tuple(slice(0, n) for n in base_shape)
+        # Two-pass moments of the new rows per cell, then merged into the stored ones
+        count = np.bincount(flat, minlength=cells)
+        with np.errstate(invalid="ignore", divide="ignore"):
+            mean = np.where(count > 0, np.bincount(flat, weights=scores, minlength=cells) / count, 0.0)
+        m2 = np.bincount(flat, weights=(scores - mean[flat]) ** 2, minlength=cells)
+        merged = _combine(np.stack([self.count[base], count.reshape(base_shape)]),
+                          np.stack([self.mean[base], mean.reshape(base_shape)]),
+                          np.stack([self.m2[base], m2.reshape(base_shape)]), axis=0)
+        self.count[base], self.mean[base], self.m2[base] = (a[0] for a in merged)
+        low = np.full(cells, np.inf)
+        high = np.full(cells, -np.inf)
+        np.minimum.at(low, flat, scores)
+        np.maximum.at(high, flat, scores)
+        self.low[base] = np.minimum(self.low[base], low.reshape(base_shape))
+        self.high[base] = np.maximum(self.high[base], high.reshape(base_shape))
+        flat_bins = flat * HISTOGRAM_BINS + bins
+        self.histogram[base] += np.bincount(flat_bins, minlength=cells * HISTOGRAM_BINS
+                                            ).reshape(base_shape + (HISTOGRAM_BINS,))
+        self.bin_total[base] += np.bincount(flat_bins, weights=scores, minlength=cells * HISTOGRAM_BINS
+                                            ).reshape(base_shape + (HISTOGRAM_BINS,))
+        self._rollup()
+
+    def _rollup(self):
+        """Recompute every cell with at least one ALL member from the base cells."""
+        base = tuple(slice(0, len(self.members[d])) for d in DIMS)
+        for mask in itertools.product([False, True], repeat=len(DIMS)):
+            if not any(mask):
+                continue
+            axes = tuple(i for i, rolled in enumerate(mask) if rolled)
+            target = tuple(slice(-1, None) if rolled else s for rolled, s in zip(mask, base))
+            if not self.count[base].size:
+                continue
+            self.count[target], self.mean[target], self.m2[target] = _combine(
+                self.count[base], self.mean[base], self.m2[base], axes)
+            self.low[target] = self.low[base].min(axis=axes, keepdims=True)
+            self.high[target] = self.high[base].max(axis=axes, keepdims=True)
+            self.histogram[target] = self.histogram[base].sum(axis=axes, keepdims=True)
+            self.bin_total[target] = self.bin_total[base].sum(axis=axes, keepdims=True)
+
+    def add_file(self, path):
+        """
+        Fold one results file (.col or .csv) into the cube.
+
+        Returns:
+            bool: False if the file (same path and bytes, or the same bytes elsewhere) was already added
+
+        Raises:
+            ValueError: a file at a recorded path changed since it was added
+        """
+        resolved, digest = str(Path(path).resolve()), _sha256(path)
+        for source in self.sources:
+            if source["path"] == resolved and source["sha256"] != digest:
+                raise ValueError(f"{path} changed since it was added to the cube; rebuild it with 'build'")
+            if source["sha256"] == digest:
+                return False
+        table = result_store.ResultTable(path)
+        self.add_table(table)
+        self.sources.append({"path": resolved, "sha256": digest, "rows": len(table)})
+        return True
+
+    # --- Queries ---
+
+    def resolve(self, dim, value):
+        """Index of a member given by name or unique prefix; ALL for "*"."""
+        if value == ALL:
+            return len(self.members[dim])
+        if value in self._index[dim]:
+            return self._index[dim][value]
+        matches = [m for m in self.members[dim] if m.startswith(value)]
+        if len(matches) != 1:
+            raise KeyError(f"{dim} {value!r}: {'ambiguous' if matches else 'no such member'} "
+                           f"({', '.join(self.members[dim])})")
+        return self._index[dim][matches[0]]
+
+    def _indices(self, selection):
+        """Per dimension the list of cube indices a selection covers."""
+        index = []
+        for d in DIMS:
+            value = selection.get(d, ALL)
+            values = value if isinstance(value, (list, tuple)) else [value]
+            index.append([self.resolve(d, v) for v in values])
+        return index
+
+    def _aggregate(self, index):
+        if all(len(i) == 1 for i in index):
+            # One cell (a base cell or a precomputed rollup): plain indexing
+            cells = tuple(i[0] for i in index)
+            count, mean, m2 = int(self.count[cells]), self.mean[cells], self.m2[cells]
+            low, high = self.low[cells], self.high[cells]
+            histogram, bin_total = self.histogram[cells], self.bin_total[cells]
+        else:
+            cells = np.ix_(*index)
+            count, mean, m2 = (a.item() for a in _combine(self.count[cells], self.mean[cells], self.m2[cells], None))
+            count = int(count)
+            low, high = self.low[cells].min(), self.high[cells].max()
+            histogram = self.histogram[cells].reshape(-1, HISTOGRAM_BINS).sum(axis=0)
+            bin_total = self.bin_total[cells].reshape(-1, HISTOGRAM_BINS).sum(axis=0)
+        if count == 0:
+            return {"count": 0, "mean": np.nan, "std": np.nan, "min": np.nan, "max": np.nan, "median": np.nan}
+        # Bins of the two middle order statistics (the same one for odd counts)
+        middle = np.searchsorted(np.cumsum(histogram), [(count + 1) // 2, count // 2 + 1])
+        return {
+            "count": count,
+            "mean": float(mean),
+            "std": float(np.sqrt(m2 / (count - 1))) if count > 1 else np.nan,
+            "min": float(low),
+            "max": float(high),
+            "median": float((bin_total[middle] / histogram[middle]).mean()),
+        }
+
+    def cell(self, **selection):
+        """
+        Aggregates of one slice.
+
+        Args:
+            selection: dim -> member, "*" or list of members; missing dims are ALL
+
+        Returns:
+            dict: count, mean, std, min, max, median
+        """
+        return self._aggregate(self._indices(selection))
+
+    def query(self, by=(), **selection):
+        """Rows of cell() for every member combination of the by dimensions within the selection."""
+        index = self._indices(selection)
+        axes = [DIMS.index(d) for d in by]
+        choices = []
+        for d, axis in zip(by, axes):
+            chosen = index[axis]
+            choices.append(range(len(self.members[d])) if chosen == [len(self.members[d])] else chosen)
+        rows = []
+        for combo in itertools.product(*choices):
+            for axis, i in zip(axes, combo):
+                index[axis] = [i]
+            result = self._aggregate(index)
+            if result["count"]:
+                rows.append({**{d: self.members[d][i] for d, i in zip(by, combo)}, **result})
+        return rows
+
+    def drill(self, limit=None, **selection):
+        """Pair rows (source, File1, File2, Score, ...) behind a slice, read from the recorded sources."""
+        filters = {}
+        for d, value in selection.items():
+            values = value if isinstance(value, (list, tuple)) else [value]
+            if ALL not in values:
+                filters[d] = [self.members[d][self.resolve(d, v)] for v in values]
+        rows = []
+        for source in self.sources:
+            if not Path(source["path"]).is_file():
+                print(f" [Error] {source['path']} is gone; its rows cannot be listed.")
+                continue
+            if _sha256(source["path"]) != source["sha256"]:
+                print(f" [Error] {source['path']} changed since it was added; rebuild the cube to list its rows.")
+                continue
+            table = result_store.ResultTable(source["path"])
+            scores = table.scores64()
+            for i in np.flatnonzero(table.mask(**filters))[:None if limit is None else limit - len(rows)]:
+                rows.append({"source": Path(source["path"]).name,
+                             **{c: table.categories(c)[table.codes(c)[i]] for c in result_store.CATEGORY_COLUMNS},
+                             "Score": float(scores[i])})
+            if limit is not None and len(rows) >= limit:
+                break
+        return rows
+
+
+def _selection(args):
+    selection = {}
+    for d in DIMS:
+        value = getattr(args, d.lower())
+        if value:
+            selection[d] = value if len(value) > 1 else value[0]
+    return selection
+
+
+def _print_rows(rows, columns):
+    print("  ".join(f"{c:>14}" for c in columns))
+    for row in rows:
+        print("  ".join(f"{row[c]:>14.3f}" if isinstance(row[c], float) else f"{row[c]!s:>14}" for c in columns))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Precomputed Task x Variant x Group x Tool cube of similarity scores")
+    parser.add_argument("--cube", type=Path, default=Path(CUBE_FILE))
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("build")
+    p.add_argument("results", nargs="*", type=Path, default=[Path(result_store.RESULTS_FILE)])
+    p = sub.add_parser("add")
+    p.add_argument("results", nargs="+", type=Path)
+    for name in ("query", "drill"):
+        p = sub.add_parser(name)
+        for d in DIMS:
+            p.add_argument(f"--{d.lower()}", nargs="+", help=f"{d} member(s); several are merged")
+        if name == "query":
+            p.add_argument("--by", nargs="+", default=[], choices=DIMS, help="One row per member of these dims")
+        else:
+            p.add_argument("--limit", type=int, default=50)
+    args = parser.parse_args()
+
+    if args.command in ("build", "add"):
+        cube = ScoreCube() if args.command == "build" else ScoreCube.load(args.cube)
+        start = time.perf_counter()
+        for path in args.results:
+            try:
+                if not cube.add_file(path):
+                    print(f" {path}: already in the cube, skipped")
+            except ValueError as e:
+                print(f" [Error] {e}")
+        elapsed = time.perf_counter() - start
+        cube.save(args.cube)
+        shape = " x ".join(f"{len(cube.members[d])} {d.lower()}s" for d in DIMS)
+        print(f"{args.cube}: {int(cube.count[(-1,) * len(DIMS)])} scores, {shape} "
+              f"({len(cube.sources)} sources, updated in {elapsed * 1000:.0f} ms)")
+        return
+
+    if not args.cube.is_file():
+        print(f" [Error] {args.cube} not found; run 'score_cube.py build' first.")
+        return
+    cube = ScoreCube.load(args.cube)
+    selection = _selection(args)
+    try:
+        if args.command == "query":
+            start = time.perf_counter()
+            rows = cube.query(args.by, **selection)
+            elapsed = time.perf_counter() - start
+            _print_rows(rows, list(args.by) + ["count", "mean", "std", "min", "max", "median"])
+            print(f"({len(rows)} rows in {elapsed * 1e6:.0f} us)")
+        else:
+            rows = cube.drill(args.limit, **selection)
+            _print_rows(rows, ["source"] + result_store.COLUMNS)
+    except KeyError as e:
+        print(f" [Error] {e.args[0]}")
+
+
+if __name__ == "__main__":
+    main()
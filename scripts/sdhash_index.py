@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Bit-sliced candidate index over sdhash (sdbf) digests.
+
+Every sdbf digest is a list of 256-byte bloom filters into which sdhash has
+inserted the SHA-1 bits of the selected 64-byte features. Instead of scoring an
+unknown binary against every stored digest, the filters are transposed into a
+column-major (bit-sliced) index: one row per bloom-filter bit position, holding
+a bitset over all stored filters. A query only touches the rows of the bits it
+has set; a handful of wide AND/popcount passes over those rows gives the number
+of shared feature bits for every stored filter at once. Only the shortlisted
+digests are then scored with the real `sdhash -c`.
+"""
+import argparse
+import base64
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+import numpy as np
+
+# --- Configuration ---
+# Number of digests handed to sdhash for full scoring
+DEFAULT_SHORTLIST = 10
+# sdhash's own reporting threshold used for the final scores
+SDHASH_THRESHOLD = 1
+
+# Popcount lookup for a single byte, used on the uint8 views of the bitsets
+POPCOUNT8 = np.array([bin(i).count("1") for i in range(256)], dtype=np.uint16)
+
+
+def parse_sdbf(line):
+    """
+    Parse one sdbf / sdbf-dd digest line.
+
+    Returns:
+        tuple: (name, filters) where filters is a (n_filters, bf_size) uint8 array.
+    """
+    parts = line.strip().split(":")
+    magic = parts[0]
+    if magic not in ("sdbf", "sdbf-dd"):
+        raise ValueError(f"Not an sdbf digest: {line[:40]!r}")
+
+    # The name may itself contain ':' so it is sliced by its declared length
+    name_len = int(parts[2])
+    head = ":".join(parts[:3]) + ":"
+    name = line[len(head):len(head) + name_len]
+    fields = line[len(head) + name_len + 1:].strip().split(":")
+    # fields: size, hash, bf_size, hash_count, mask, max_elem, bf_count, ...
+    bf_size = int(fields[2])
+    bf_count = int(fields[6])
+
+    if magic == "sdbf":
+        # ... last_count, base64(all filters)
+        raw = base64.b64decode(fields[8])
+        filters = np.frombuffer(raw, dtype=np.uint8).reshape(bf_count, bf_size)
+    else:
+        # ... dd_block_size, then (elem_count_hex, base64(filter)) per filter
+        chunks = [base64.b64decode(b64) for b64 in fields[9:8 + 2 * bf_count:2]]
+        filters = np.frombuffer(b"".join(chunks), dtype=np.uint8).reshape(bf_count, bf_size)
+    return name, filters
+
+
+def load_digests(paths):
+    """Read every digest line from a list of .sdhash files."""
+    digests = []
+    for path in paths:
+        for line in Path(path).read_text().splitlines():
+            if line.strip():
+                digests.append(parse_sdbf(line))
+    return digests
+
+
+class SdhashIndex:
+    """Column-major bitset index over the bloom filters of many sdbf digests."""
+
+    def __init__(self, digests):
+        self.names = [name for name, _ in digests]
+        filters = [f for _, f in digests]
+        if not filters:
+            raise ValueError("Cannot build an index from zero digests")
+        self.bf_bits = filters[0].shape[1] * 8
+
+        # Filter -> owning digest, so per-filter hits can be folded per digest
+        self.owner = np.concatenate([np.full(len(f), i, dtype=np.int32) for i, f in enumerate(filters)])
+        all_filters = np.concatenate(filters)
+        self.n_filters = len(all_filters)
+        self.filter_popcount = POPCOUNT8[all_filters].sum(axis=1).astype(np.float32)
+
+        # Transpose: row b is the bitset (over filters) of bloom bit b
+        bits = np.unpackbits(all_filters, axis=1, bitorder="little")  # (n_filters, bf_bits)
+        self.slices = np.packbits(bits.T, axis=1, bitorder="little")  # (bf_bits, ceil(n/8))
+
+    def shared_bits(self, query_filter):
+        """Number of bloom bits every indexed filter shares with one query filter."""
+        set_bits = np.flatnonzero(np.unpackbits(query_filter, bitorder="little"))
+        # Vertical counters: add up the selected slices, one bit column per filter
+        counts = np.unpackbits(self.slices[set_bits], axis=1, bitorder="little", count=self.n_filters)
+        return counts.sum(axis=0, dtype=np.int32), len(set_bits)
+
+    def candidates(self, query_filters, top=DEFAULT_SHORTLIST):
+        """
+        Rank indexed digests by estimated feature overlap with a query digest.
+
+        The per-filter estimate mirrors sdhash: shared bits above the number
+        expected by chance, scaled by the smaller filter's population. A digest
+        scores the mean over query filters of its best-matching filter.
+        """
+        best = np.zeros((len(query_filters), len(self.names)), dtype=np.float32)
+        for qi, qf in enumerate(query_filters):
+            shared, q_pop = self.shared_bits(qf)
+            expected = q_pop * self.filter_popcount / self.bf_bits
+            span = np.maximum(np.minimum(q_pop, self.filter_popcount) - expected, 1.0)
+            score = np.clip((shared - expected) / span, 0.0, 1.0) * 100
+            np.maximum.at(best[qi], self.owner, score)
+        estimate = best.mean(axis=0)
+        order = np.argsort(-estimate, kind="stable")[:top]
+        return [(self.names[i], float(estimate[i])) for i in order]
+
+
+def score_shortlist(query_line, digest_lines, threshold=SDHASH_THRESHOLD):
+    """Run the real sdhash comparison on the shortlisted digests only."""
+    with tempfile.TemporaryDirectory() as tmp:
+        query_path = Path(tmp) / "query.sdhash"
+        ref_path = Path(tmp) / "shortlist.sdhash"
+        query_path.write_text(query_line + "\n")
+        ref_path.write_text("\n".join(digest_lines) + "\n")
+        try:
+            result = subprocess.run(
+                ["sdhash", "-c", str(query_path), str(ref_path), "-t", str(threshold), "--separator", "csv"],
+                check=True, text=True, capture_output=True)
+        except subprocess.CalledProcessError as e:
+            # sdhash exits with 1 when nothing reaches the threshold
+            if e.returncode == 1:
+                return []
+            raise
+    scores = []
+    for line in result.stdout.splitlines():
+        parts = line.split(",")
+        if len(parts) == 3:
+            scores.append((parts[0].strip(), parts[1].strip(), parts[2].strip()))
+    return scores
+
+
+def read_digest_lines(paths):
+    """Map digest name -> raw line, keeping the text needed for sdhash -c."""
+    lines = {}
+    for path in paths:
+        for line in Path(path).read_text().splitlines():
+            if line.strip():
+                name, _ = parse_sdbf(line)
+                lines[name] = line.strip()
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Shortlist sdhash candidates with a bit-sliced index")
+    parser.add_argument("query", help="Query binary, or an .sdhash digest file")
+    parser.add_argument("references", nargs="+", help=".sdhash digest files to index")
+    parser.add_argument("--top", type=int, default=DEFAULT_SHORTLIST, help="Shortlist size")
+    parser.add_argument("--no-score", action="store_true", help="Only print the index estimates")
+    args = parser.parse_args()
+
+    ref_lines = read_digest_lines(args.references)
+    index = SdhashIndex([parse_sdbf(line) for line in ref_lines.values()])
+    print(f"Indexed {len(index.names)} digests / {index.n_filters} filters")
+
+    if args.query.endswith(".sdhash"):
+        query_line = Path(args.query).read_text().splitlines()[0].strip()
+    else:
+        query_line = subprocess.run(["sdhash", args.query], check=True, text=True,
+                                    capture_output=True).stdout.splitlines()[0].strip()
+    _, query_filters = parse_sdbf(query_line)
+
+    shortlist = index.candidates(query_filters, top=args.top)
+    print("\n Candidate estimate")
+    for name, estimate in shortlist:
+        print(f" {name:<40} {estimate:6.1f}")
+
+    if args.no_score:
+        return
+    scores = score_shortlist(query_line, [ref_lines[name] for name, _ in shortlist])
+    print("\n sdhash score")
+    if not scores:
+        print(" No matches found with score >= 1.")
+    for f1, f2, sc in scores:
+        print(f" {f1} vs {f2}: {sc}")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Source-line attribution of a debug (-g) binary and of its similarity to other builds.
+
+build_variants.py writes <N>_g next to the other variants: the baseline
+command plus -g, so its code is byte-for-byte the code of <N>_base and the
+DWARF line table (dwarf.py) says which source line every instruction came
+from. The code is cut into the same position-independent basic blocks as the
+blockhash tool; for every other build of the program (_O3, _cff, ...), a
+block counts as shared when its hash also occurs there. Summing instruction
+bytes per (source line, function) then shows which source constructs survive
+a transformation and which ones account for the blockhash similarity, in one
+pass over each debug binary.
+
+Lines are attributed to the function whose code contains them, so a line
+inlined into main shows up under main as well as under its own function.
+Over the corpus (no files given) every *_g binary is compared with its
+siblings and the rows go to line_attribution.csv.
+"""
+import argparse
+import csv
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+import block_hash
+import dwarf
+import elf_utils
+from cfg_metrics import describe_binary
+
+# --- Configuration ---
+OUTPUT_DIR = Path(__file__).parent.parent / "output"
+CORPUS_DIR = Path(__file__).parent.parent / "corpus"
+ATTRIBUTION_CSV = "line_attribution.csv"
+DEBUG_SUFFIX = "_g"
+
+
+# Source file lines by the path the line table names; every worker process
+# reads each source once, and the sources do not change during a run
+_SOURCE_LINES = {}
+
+
+def _source_lines(path):
+    """Lines of a source file named in the line table; corpus files are found by task/group/name."""
+    if path not in _SOURCE_LINES:
+        candidates = [Path(path)]
+        parts = Path(path).parts
+        if len(parts) >= 3:
+            candidates.append(CORPUS_DIR.joinpath(*parts[-3:]))
+        _SOURCE_LINES[path] = next((p.read_text(errors="replace").splitlines() for p in candidates if p.is_file()), [])
+    return _SOURCE_LINES[path]
+
+
+def attribute(debug_path, others, mask_immediates=False):
+    """
+    Bytes per (source file, line, function) of a debug binary and how many are shared.
+
+    Args:
+        others: {variant name: path} of the builds to compare against.
+
+    Returns:
+        list: row dicts with file, line, function, insns, bytes, one
+        shared_<variant> byte count per entry of others, and the source text.
+    """
+    elf = elf_utils.ELFFile(debug_path)
+    info = dwarf.DebugInfo(elf)
+    if not info.has_dwarf:
+        raise ValueError(f"{debug_path} has no .debug_line (not a -g build)")
+    other_hashes = {name: set(block_hash.block_hashes(path, mask_immediates).tolist())
+                    for name, path in others.items()}
+
+    rows = {}
+    regions, image = block_hash.code_regions(debug_path)
+    for code, addr in regions:
+        for digest, insns in block_hash.region_blocks(code, addr, image, mask_immediates):
+            value = int(np.frombuffer(digest, dtype=np.uint64)[0])
+            shared = [name for name, hashes in other_hashes.items() if value in hashes]
+            for insn in insns:
+                location = info.lines.lookup(insn.addr)
+                if location is None:
+                    continue    # crt code linked without debug info
+                key = (*location, info.function_at(insn.addr))
+                row = rows.get(key)
+                if row is None:
+                    row = rows[key] = {"insns": 0, "bytes": 0, **{name: 0 for name in others}}
+                row["insns"] += 1
+                row["bytes"] += insn.size
+                for name in shared:
+                    row[name] += insn.size
+
+    result = []
+    for (path, line, function), row in sorted(rows.items(), key=lambda item: item[0]):
+        lines = _source_lines(path)
+        result.append({
+            "file": Path(path).name,
+            "line": line,
+            "function": function,
+            "insns": row["insns"],
+            "bytes": row["bytes"],
+            **{f"shared{name}": row[name] for name in others},
+            "source": lines[line - 1].strip() if 0 < line <= len(lines) else "",
+        })
+    return result
+
+
+def sibling_builds(debug_path):
+    """{variant suffix: path} of the other builds of the program a *_g binary belongs to."""
+    debug_path = Path(debug_path)
+    program = debug_path.name[:-len(DEBUG_SUFFIX)]
+    siblings = {}
+    for path in sorted(debug_path.parent.glob(f"{program}_*")):
+        suffix = path.name[len(program):]
+        if path != debug_path and path.is_file() and "_" not in suffix[1:].replace("clang_O2", ""):
+            siblings[suffix] = str(path)
+    return siblings
+
+
+def _attribute(path):
+    try:
+        return path, attribute(path, sibling_builds(path)), None
+    except (ValueError, IndexError, OSError) as e:
+        return path, [], str(e)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-source-line attribution of -g binaries and of their similarity")
+    parser.add_argument("debug", nargs="?", type=Path, help="A -g binary (default: every *_g under --output-dir)")
+    parser.add_argument("--against", nargs="*", type=Path, default=None,
+                        help="Builds to compare with (default: the siblings of the -g binary)")
+    parser.add_argument("--output-dir", type=Path, default=OUTPUT_DIR)
+    parser.add_argument("--csv", default=ATTRIBUTION_CSV)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    if args.debug:
+        others = ({p.name: str(p) for p in args.against} if args.against is not None
+                  else sibling_builds(args.debug))
+        rows = attribute(args.debug, others)
+        print(f"{args.debug}: {len(rows)} source lines, compared with {', '.join(others) or 'nothing'}")
+        for row in rows:
+            shares = " ".join(f"{name}={row['shared' + name]}" for name in others)
+            print(f"  {row['file']}:{row['line']:<5} {row['function']:<20} {row['bytes']:>4} B  {shares}  "
+                  f"| {row['source'][:60]}")
+        return
+
+    files = sorted(p for p in args.output_dir.glob(f"*/*/*{DEBUG_SUFFIX}") if p.is_file())
+    if not files:
+        print(f" [Error] No *{DEBUG_SUFFIX} binaries under {args.output_dir}; rebuild with build_variants.py.")
+        return
+    print(f"Attributing {len(files)} debug binaries...")
+    start = time.perf_counter()
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        results = list(pool.map(_attribute, [str(f) for f in files]))
+    elapsed = time.perf_counter() - start
+
+    out_rows = []
+    for path, rows, error in results:
+        if error:
+            print(f" [Error] {path}: {error}")
+            continue
+        info = describe_binary(path, args.output_dir)
+        program = Path(path).name[:-len(DEBUG_SUFFIX)]
+        out_rows.extend({"task": info["task"], "group": info["group"], "program": program, **row} for row in rows)
+    # Programs have different sibling sets; keep the source text last, after every shared* column
+    fields = [k for k in dict.fromkeys(k for row in out_rows for k in row) if k != "source"] + ["source"]
+    with open(args.csv, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=fields, restval="")
+        writer.writeheader()
+        writer.writerows(out_rows)
+    print(f"Done in {elapsed:.2f}s: {len(out_rows)} (line, function) rows")
+    print(f"Results saved to: {args.csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+C tokenizer and source metrics for the corpus sources.
+
+One compiled master pattern (an alternation of named token classes) scans each
+file; tokens are consumed as they are matched rather than collected into a
+token list. Besides the counters and the current function, the scan keeps the
+sets of distinct identifiers and of code and comment line numbers.
+Per file it reports:
+
+  - token counts by class (identifier, keyword, number, string, char, operator)
+  - distinct identifiers by naming style (snake_case, camelCase, PascalCase,
+    UPPER_CASE, lower, other)
+  - line counts and comment density (comment lines / non-blank lines)
+  - #include set
+  - switch statements and case labels
+  - functions with McCabe cyclomatic complexity: 1 + if, for, while, case,
+    ?:, && and || inside the body (preprocessor lines are skipped)
+
+Sources are processed in worker processes; results go to source_metrics.csv
+(one row per file) and source_functions.csv (one row per function).
+"""
+import argparse
+import csv
+import os
+import re
+import time
+from collections import Counter
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+# --- Configuration ---
+CORPUS_DIR = Path(__file__).parent.parent / "corpus"
+FILES_CSV = "source_metrics.csv"
+FUNCTIONS_CSV = "source_functions.csv"
+
+KEYWORDS = frozenset("""
+    auto break case char const continue default do double else enum extern float for goto if inline
+    int long register restrict return short signed sizeof static struct switch typedef union unsigned
+    void volatile while _Alignas _Alignof _Atomic _Bool _Complex _Generic _Imaginary _Noreturn
+    _Static_assert _Thread_local
+""".split())
+# Tokens that add a decision to the enclosing function
+DECISIONS = frozenset(["if", "for", "while", "case", "?", "&&", "||"])
+STYLES = ["snake_case", "camelCase", "PascalCase", "UPPER_CASE", "lower", "other"]
+
+TOKEN = re.compile(r"""
+    (?P<newline>\n)
+  | (?P<space>[ \t\r\f\v]+)
+  | (?P<comment>//[^\n]*|/\*.*?(?:\*/|\Z))
+  | (?P<directive>\#(?:[^\n\\]|\\.|\\\n)*)
+  | (?P<string>(?:u8|[uUL])?"(?:[^"\\\n]|\\.)*"?)
+  | (?P<char>(?:[uUL])?'(?:[^'\\\n]|\\.)*'?)
+  | (?P<number>\.?[0-9](?:[eEpP][+-]|[0-9a-zA-Z_.])*)
+  | (?P<identifier>[A-Za-z_][A-Za-z0-9_]*)
+  | (?P<operator>\.\.\.|<<=|>>=|->|\+\+|--|<<|>>|<=|>=|==|!=|&&|\|\||[-+*/%&|^!=<>]=|\#\#|[-+*/%&|^~!=<>?:.,;(){}\[\]\#])
+  | (?P<other>.)
+""", re.VERBOSE | re.DOTALL)
+_INCLUDE = re.compile(r"\#\s*include\s*([<\"][^>\"]+[>\"])")
+
+
+def identifier_style(name):
+    """Naming style of one identifier."""
+    core = name.strip("_")
+    if not core:
+        return "other"
+    if core.isupper() or (core.replace("_", "").isupper() and "_" in core):
+        return "UPPER_CASE"
+    if "_" in core:
+        return "snake_case" if core.islower() or not any(c.isupper() for c in core) else "other"
+    if core.islower() or core.isdigit():
+        return "lower"
+    if core[0].isupper():
+        return "PascalCase"
+    return "camelCase"
+
+
+def analyze_source(text):
+    """
+    Metrics of one C source.
+
+    Returns:
+        tuple: (file metrics dict, [(function, line, cyclomatic, tokens)])
+    """
+    counts = Counter()
+    identifiers = set()
+    includes = []
+    code_lines, comment_lines = set(), set()
+    functions = []
+
+    line = 1
+    depth = 0
+    # Function detection: an identifier followed by a parenthesised list at file
+    # scope, then "{" (K&R parameter declarations in between are allowed)
+    candidate = None        # (name, line) of the last identifier before "(" at depth 0
+    paren = 0
+    pending = None          # candidate whose ")" closed, waiting for "{" or ";"
+    current = None          # [name, line, decisions, tokens] of the open function
+    last_identifier = None
+
+    for m in TOKEN.finditer(text):
+        kind = m.lastgroup
+        if kind == "newline":
+            line += 1
+            continue
+        if kind == "space":
+            continue
+        value = m.group()
+        newlines = value.count("\n")
+        if kind == "comment":
+            comment_lines.update(range(line, line + newlines + 1))
+            line += newlines
+            continue
+        code_lines.update(range(line, line + newlines + 1))
+        if kind == "directive":
+            include = _INCLUDE.match(value)
+            if include:
+                includes.append(include.group(1))
+            counts["directive"] += 1
+            line += newlines
+            continue
+
+        if kind == "identifier" and value in KEYWORDS:
+            kind = "keyword"
+            if value in ("switch", "case"):
+                counts[value] += 1
+        counts[kind] += 1
+        if kind == "identifier":
+            identifiers.add(value)
+        if current is not None:
+            current[3] += 1
+            if value in DECISIONS and kind in ("keyword", "operator"):
+                current[2] += 1
+
+        if value == "{":
+            if depth == 0 and pending is not None:
+                current = [pending[0], pending[1], 0, 1]
+            pending = None
+            depth += 1
+        elif value == "}":
+            depth = max(depth - 1, 0)
+            if depth == 0 and current is not None:
+                functions.append((current[0], current[1], 1 + current[2], current[3]))
+                current = None
+        elif depth == 0:
+            if value == "(":
+                if paren == 0:
+                    candidate = last_identifier
+                paren += 1
+            elif value == ")" and paren:
+                paren -= 1
+                if paren == 0 and candidate is not None:
+                    pending = candidate
+            elif value in (";", "=", ","):
+                if paren == 0:
+                    pending = None
+        last_identifier = (value, line) if kind == "identifier" and paren == 0 else None
+        line += newlines
+
+    styles = Counter(identifier_style(name) for name in identifiers)
+    nonblank = len(code_lines | comment_lines)
+    complexities = [cc for _, _, cc, _ in functions]
+    metrics = {
+        "lines": line if text and not text.endswith("\n") else line - 1,
+        "code_lines": len(code_lines),
+        "comment_lines": len(comment_lines),
+        "comment_density": round(len(comment_lines) / nonblank, 4) if nonblank else 0.0,
+        "tokens": sum(counts[k] for k in ("identifier", "keyword", "number", "string", "char", "operator", "other")),
+        **{k: counts[k] for k in ("identifier", "keyword", "number", "string", "char", "operator", "directive")},
+        "distinct_identifiers": len(identifiers),
+        **{f"style_{s}": styles[s] for s in STYLES},
+        "switch": counts["switch"],
+        "case": counts["case"],
+        "functions": len(functions),
+        "max_cyclomatic": max(complexities, default=0),
+        "mean_cyclomatic": round(sum(complexities) / len(complexities), 3) if complexities else 0.0,
+        "includes": " ".join(sorted(set(includes))),
+    }
+    return metrics, functions
+
+
+def _analyze(path):
+    try:
+        text = Path(path).read_text(errors="replace")
+    except OSError as e:
+        return path, None, [], str(e)
+    metrics, functions = analyze_source(text)
+    return path, metrics, functions, None
+
+
+def describe_source(path, corpus_dir):
+    """task / group / program columns derived from corpus/<task>/<group>/<N>.c."""
+    path = Path(path)
+    try:
+        task, group, _ = path.relative_to(corpus_dir).parts
+    except ValueError:
+        task, group = "", ""
+    return {"task": task, "group": group, "program": path.stem}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Token, style, comment, include and cyclomatic metrics of C sources")
+    parser.add_argument("files", nargs="*", type=Path, help="Sources to analyze (default: every corpus/*/*/*.c)")
+    parser.add_argument("--corpus-dir", type=Path, default=CORPUS_DIR)
+    parser.add_argument("--csv", default=FILES_CSV)
+    parser.add_argument("--functions-csv", default=FUNCTIONS_CSV)
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    files = [str(f) for f in args.files] or sorted(str(p) for p in args.corpus_dir.glob("*/*/*.c"))
+    print(f"Analyzing {len(files)} C sources...")
+    start = time.perf_counter()
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        results = list(pool.map(_analyze, files, chunksize=max(1, len(files) // (4 * (args.workers or 1)))))
+    elapsed = time.perf_counter() - start
+
+    file_rows, function_rows = [], []
+    for path, metrics, functions, error in results:
+        if error:
+            print(f" [Error] {path}: {error}")
+            continue
+        info = describe_source(path, args.corpus_dir)
+        file_rows.append({**info, **metrics})
+        function_rows.extend({**info, "function": name, "line": line, "cyclomatic": cc, "tokens": tokens}
+                             for name, line, cc, tokens in functions)
+
+    if file_rows:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(file_rows[0]))
+            writer.writeheader()
+            writer.writerows(file_rows)
+    with open(args.functions_csv, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=["task", "group", "program", "function", "line", "cyclomatic", "tokens"])
+        writer.writeheader()
+        writer.writerows(function_rows)
+    rate = len(files) / elapsed * 60 if elapsed else 0
+    print(f"Done in {elapsed:.2f}s ({rate:,.0f} files/min): {len(function_rows)} functions")
+    print(f"Results saved to: {args.csv}, {args.functions_csv}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+MOSS-style winnowing similarity of the corpus C sources.
+
+Each source is tokenized with the source_metrics lexer and normalized:
+comments and preprocessor lines are dropped, identifiers become V, numbers N,
+strings S and characters C, while keywords and operators stay as they are,
+so renaming variables or reformatting does not change the stream. Every k-gram
+of the stream is hashed, and winnowing keeps the minimum hash of each window
+of w consecutive k-grams (the rightmost one on ties). Any match of at least
+w + k - 1 tokens is therefore guaranteed to share a fingerprint.
+
+An inverted index from fingerprint to sources gives the shared fingerprint
+count of every pair by walking each posting list once; fingerprints found in
+more than --max-df of the sources (boilerplate such as the main/scanf
+skeleton) are skipped. Scores are Jaccard on the 0-100 scale.
+
+Pairs are written with the names of the binaries built from the sources
+(output/<task>/<group>/<N><variant>), the same File1/File2 columns as
+call_graph.py and import_set.py, so --compare can correlate the source
+matrix with any binary pairs file directly.
+"""
+import argparse
+import csv
+import hashlib
+import itertools
+import os
+import struct
+import time
+from collections import Counter
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+
+import numpy as np
+
+from source_metrics import CORPUS_DIR, KEYWORDS, TOKEN, describe_source
+
+# --- Configuration ---
+PAIRS_CSV = "source_pairs.csv"
+KGRAM = 8
+WINDOW = 4
+MAX_DF = 0.5
+BINARY_VARIANT = "_base"
+
+_PLACEHOLDER = {"identifier": "V", "number": "N", "string": "S", "char": "C"}
+_SKIPPED = frozenset(["newline", "space", "comment", "directive"])
+
+
+def normalized_tokens(text):
+    """Normalized token stream of one source as a list of strings."""
+    tokens = []
+    for m in TOKEN.finditer(text):
+        kind = m.lastgroup
+        if kind in _SKIPPED:
+            continue
+        value = m.group()
+        if kind == "identifier" and value in KEYWORDS:
+            tokens.append(value)
+        else:
+            tokens.append(_PLACEHOLDER.get(kind, value))
+    return tokens
+
+
+def _token_hash(token):
+    return struct.unpack("<Q", hashlib.blake2b(token.encode(), digest_size=8).digest())[0]
+
+
+def fingerprints(tokens, k=KGRAM, w=WINDOW):
+    """Winnowed k-gram hashes of a token stream as a sorted unique uint64 array."""
+    if len(tokens) < k:
+        return np.empty(0, dtype=np.uint64)
+    ids = np.array([_token_hash(t) for t in tokens], dtype=np.uint64)
+    # Polynomial hash of every k-gram (wrapping uint64 arithmetic)
+    kgrams = np.zeros(len(ids) - k + 1, dtype=np.uint64)
+    for i in range(k):
+        kgrams = kgrams * np.uint64(0x100000001B3) + ids[i:i + len(kgrams)]
+    if len(kgrams) <= w:
+        return np.unique(kgrams[[len(kgrams) - 1 - np.argmin(kgrams[::-1])]])
+    windows = np.lib.stride_tricks.sliding_window_view(kgrams, w)
+    # Rightmost minimum of every window
+    picked = np.arange(len(windows)) + w - 1 - np.argmin(windows[:, ::-1], axis=1)
+    return np.unique(kgrams[picked])
+
+
+def _fingerprint(args):
+    path, k, w = args
+    try:
+        text = Path(path).read_text(errors="replace")
+    except OSError as e:
+        return path, np.empty(0, dtype=np.uint64), str(e)
+    return path, fingerprints(normalized_tokens(text), k, w), None
+
+
+def similarity_matrix(prints, max_df=MAX_DF):
+    """
+    All-pairs Jaccard of fingerprint sets through an inverted index.
+
+    Returns:
+        numpy array: (n, n) scores, 0-100, 100 on the diagonal
+    """
+    n = len(prints)
+    index = {}
+    for doc, fp in enumerate(prints):
+        for h in fp.tolist():
+            index.setdefault(h, []).append(doc)
+    limit = max(2, int(max_df * n))
+    kept = [0] * n
+    shared = Counter()
+    for docs in index.values():
+        if len(docs) > limit:
+            continue
+        for doc in docs:
+            kept[doc] += 1
+        for pair in itertools.combinations(docs, 2):
+            shared[pair] += 1
+    scores = np.zeros((n, n))
+    for (i, j), count in shared.items():
+        scores[i, j] = scores[j, i] = 100 * count / (kept[i] + kept[j] - count)
+    np.fill_diagonal(scores, 100.0)
+    return np.round(scores, 2)
+
+
+def compare(scores, names, path):
+    """Spearman correlation between the source scores and a binary File1/File2/Score CSV."""
+    from scipy import stats
+
+    row = {name: i for i, name in enumerate(names)}
+    source, binary = [], []
+    with open(path, newline="") as f:
+        for rec in csv.DictReader(f):
+            i, j = row.get(rec["File1"]), row.get(rec["File2"])
+            if i is None or j is None or i == j:
+                continue
+            try:
+                binary.append(float(rec["Score"]))
+            except ValueError:
+                continue
+            source.append(scores[i, j])
+    if len(source) < 3:
+        return len(source), float("nan")
+    return len(source), stats.spearmanr(source, binary).statistic
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Winnowing similarity of C sources with an inverted index")
+    parser.add_argument("files", nargs="*", type=Path, help="Sources to compare (default: every corpus/*/*/*.c)")
+    parser.add_argument("--corpus-dir", type=Path, default=CORPUS_DIR)
+    parser.add_argument("--csv", default=PAIRS_CSV)
+    parser.add_argument("-k", type=int, default=KGRAM, help="Tokens per k-gram")
+    parser.add_argument("-w", type=int, default=WINDOW, help="Winnowing window in k-grams")
+    parser.add_argument("--max-df", type=float, default=MAX_DF,
+                        help="Ignore fingerprints shared by more than this fraction of sources")
+    parser.add_argument("--variant", default=BINARY_VARIANT, help="Binary suffix used to name the pairs")
+    parser.add_argument("--compare", nargs="*", default=[], help="Binary pairs CSVs to correlate against")
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    files = [str(f) for f in args.files] or sorted(str(p) for p in args.corpus_dir.glob("*/*/*.c"))
+    start = time.perf_counter()
+    with ProcessPoolExecutor(max_workers=args.workers) as pool:
+        results = list(pool.map(_fingerprint, [(f, args.k, args.w) for f in files], chunksize=16))
+    for path, _, error in results:
+        if error:
+            print(f" [Error] {path}: {error}")
+    scores = similarity_matrix([fp for _, fp, _ in results], args.max_df)
+    elapsed = time.perf_counter() - start
+
+    names = []
+    for f in files:
+        info = describe_source(f, args.corpus_dir)
+        names.append(f"{info['task']}/{info['group']}/{info['program']}{args.variant}"
+                     if info["task"] else Path(f).name)
+    with open(args.csv, "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["File1", "File2", "Score"])
+        for i, j in zip(*np.triu_indices(len(files), k=1)):
+            writer.writerow([names[i], names[j], scores[i, j]])
+    print(f"Done in {elapsed * 1000:.0f} ms: {len(files)} sources, "
+          f"{sum(len(fp) for _, fp, _ in results)} fingerprints (k={args.k}, w={args.w})")
+    print(f"Pairs saved to: {args.csv}")
+    for path in args.compare:
+        count, rho = compare(scores, names, path)
+        print(f" {path}: Spearman rho {rho:.3f} over {count} pairs")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+Content-addressed store of the Tigress-transformed C sources.
+
+build_variants.py used to delete <N>_flat_temp.c and <N>_elit_temp.c right
+after compiling them; it now puts them here first. One SQLite file holds
+
+    sources: sha256 of the text -> zlib-compressed text (stored once)
+    builds:  task, group, program, transform, seed -> sha256, plus the gcc
+             time and size of the binary built from it
+
+so every campaign adds its builds to the same index while identical outputs
+share one blob. The blow-up of a transform is measured by running the
+source_metrics lexer over the stored text and over the corpus original:
+ratios of functions, lines, tokens and switch/case labels. Linear fits of
+compile time and binary size against the tokens of the original source,
+per transform, predict the cost of a campaign before Tigress runs.
+
+Commands:
+  stats                   stored blobs and builds per transform
+  blowup [--csv OUT]      per-build metrics and ratios to the original
+  predict SOURCE...       predicted compile time and binary size per transform
+  show SHA256             print one stored source (a unique prefix is enough)
+"""
+import argparse
+import csv
+import hashlib
+import sqlite3
+import time
+import zlib
+from pathlib import Path
+
+import numpy as np
+
+from source_metrics import CORPUS_DIR, analyze_source
+
+# --- Configuration ---
+DEFAULT_STORE = Path(__file__).parent.parent / "transformed_sources.sqlite"
+BLOWUP_CSV = "transform_blowup.csv"
+COMPRESS_LEVEL = 9
+# source_metrics columns compared between the transformed text and its original
+BLOWUP_METRICS = ["functions", "lines", "code_lines", "tokens", "switch", "case"]
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS sources (
+    sha256 TEXT PRIMARY KEY,
+    size   INTEGER NOT NULL,
+    data   BLOB NOT NULL
+);
+CREATE TABLE IF NOT EXISTS builds (
+    task            TEXT NOT NULL,
+    grp             TEXT NOT NULL,
+    program         TEXT NOT NULL,
+    transform       TEXT NOT NULL,
+    seed            TEXT NOT NULL,
+    sha256          TEXT NOT NULL REFERENCES sources(sha256),
+    compile_seconds REAL,
+    binary_bytes    INTEGER,
+    built_at        REAL NOT NULL,
+    PRIMARY KEY (task, grp, program, transform, seed)
+);
+"""
+
+
+class SourceStore:
+    """SQLite-backed content-addressed store of transformed sources."""
+
+    def __init__(self, path=DEFAULT_STORE):
+        self.path = Path(path)
+        self.db = sqlite3.connect(self.path)
+        self.db.executescript(_SCHEMA)
+
+    def close(self):
+        self.db.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def put(self, text):
+        """Store a source text once; returns its sha256."""
+        data = text.encode()
+        sha256 = hashlib.sha256(data).hexdigest()
+        with self.db:
+            self.db.execute("INSERT OR IGNORE INTO sources VALUES (?, ?, ?)",
+                            (sha256, len(data), zlib.compress(data, COMPRESS_LEVEL)))
+        return sha256
+
+    def get(self, sha256):
+        """Stored text of a sha256 or a unique prefix of one."""
+        rows = self.db.execute("SELECT data FROM sources WHERE sha256 LIKE ? LIMIT 2", (sha256 + "%",)).fetchall()
+        if len(rows) != 1:
+            raise KeyError(f"{sha256}: {'ambiguous prefix' if rows else 'not in the store'}")
+        return zlib.decompress(rows[0][0]).decode()
+
+    def record(self, source_path, task, group, program, transform, seed, compile_seconds=None, binary_path=None):
+        """Store a transformed source file and index the build made from it."""
+        sha256 = self.put(Path(source_path).read_text(errors="replace"))
+        binary_bytes = Path(binary_path).stat().st_size if binary_path and Path(binary_path).is_file() else None
+        with self.db:
+            self.db.execute("INSERT OR REPLACE INTO builds VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                            (task, group, program, transform, str(seed), sha256,
+                             compile_seconds, binary_bytes, time.time()))
+        return sha256
+
+    def builds(self):
+        """Every indexed build as a dict, oldest first."""
+        cursor = self.db.execute("SELECT task, grp, program, transform, seed, sha256, compile_seconds, binary_bytes "
+                                 "FROM builds ORDER BY built_at")
+        keys = ["task", "group", "program", "transform", "seed", "sha256", "compile_seconds", "binary_bytes"]
+        return [dict(zip(keys, row)) for row in cursor]
+
+    def stats(self):
+        """(blobs, raw bytes, compressed bytes) and [(transform, builds)]."""
+        blobs = self.db.execute("SELECT COUNT(*), COALESCE(SUM(size), 0), COALESCE(SUM(LENGTH(data)), 0) "
+                                "FROM sources").fetchone()
+        per_transform = self.db.execute("SELECT transform, COUNT(*) FROM builds GROUP BY transform "
+                                        "ORDER BY transform").fetchall()
+        return blobs, per_transform
+
+
+def blowup(store, corpus_dir=CORPUS_DIR):
+    """
+    Metrics of every stored build next to those of its corpus original.
+
+    Returns:
+        list: row dicts with the build columns, <metric>, orig_<metric> and
+        <metric>_ratio for each of BLOWUP_METRICS
+    """
+    originals, transformed = {}, {}
+    rows = []
+    for build in store.builds():
+        key = (build["task"], build["group"], build["program"])
+        if key not in originals:
+            source = corpus_dir / build["task"] / build["group"] / f"{build['program']}.c"
+            originals[key] = analyze_source(source.read_text(errors="replace"))[0] if source.is_file() else None
+        if build["sha256"] not in transformed:
+            transformed[build["sha256"]] = analyze_source(store.get(build["sha256"]))[0]
+        original, metrics = originals[key], transformed[build["sha256"]]
+        row = dict(build)
+        for name in BLOWUP_METRICS:
+            row[name] = metrics[name]
+            row[f"orig_{name}"] = original[name] if original else ""
+            row[f"{name}_ratio"] = (round(metrics[name] / original[name], 3)
+                                    if original and original[name] else "")
+        rows.append(row)
+    return rows
+
+
+def fit(rows, target):
+    """
+    Per-transform least-squares line target = slope * orig_tokens + intercept.
+
+    Returns:
+        dict: transform -> (slope, intercept, r2, builds); transforms with
+        fewer than two usable builds are left out
+    """
+    models = {}
+    for transform in sorted({r["transform"] for r in rows}):
+        usable = [r for r in rows if r["transform"] == transform and r[target] is not None and r["orig_tokens"] != ""]
+        x = np.array([r["orig_tokens"] for r in usable], dtype=float)
+        y = np.array([r[target] for r in usable], dtype=float)
+        if len(usable) < 2 or np.ptp(x) == 0:
+            continue
+        slope, intercept = np.polyfit(x, y, 1)
+        residual = y - (slope * x + intercept)
+        total = np.sum((y - y.mean()) ** 2)
+        r2 = 1 - np.sum(residual ** 2) / total if total else 1.0
+        models[transform] = (slope, intercept, r2, len(usable))
+    return models
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Content-addressed store and blow-up metrics of transformed sources")
+    parser.add_argument("--store", type=Path, default=DEFAULT_STORE)
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("stats")
+    p = sub.add_parser("blowup")
+    p.add_argument("--corpus-dir", type=Path, default=CORPUS_DIR)
+    p.add_argument("--csv", default=BLOWUP_CSV)
+    p = sub.add_parser("predict")
+    p.add_argument("sources", nargs="+", type=Path)
+    p.add_argument("--corpus-dir", type=Path, default=CORPUS_DIR)
+    p = sub.add_parser("show")
+    p.add_argument("sha256")
+    args = parser.parse_args()
+
+    with SourceStore(args.store) as store:
+        if args.command == "stats":
+            (blobs, raw, packed), per_transform = store.stats()
+            print(f"{args.store}: {blobs} sources, {raw:,} bytes ({packed:,} compressed)")
+            for transform, count in per_transform:
+                print(f"  {transform:<10} {count} builds")
+
+        elif args.command == "show":
+            try:
+                print(store.get(args.sha256), end="")
+            except KeyError as e:
+                print(f" [Error] {e.args[0]}")
+
+        elif args.command == "blowup":
+            start = time.perf_counter()
+            rows = blowup(store, args.corpus_dir)
+            elapsed = time.perf_counter() - start
+            if not rows:
+                print(f" [Error] No builds in {args.store}; run build_variants.py first.")
+                return
+            with open(args.csv, "w", newline="") as f:
+                writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+                writer.writeheader()
+                writer.writerows(rows)
+            print(f"Done in {elapsed:.2f}s: {len(rows)} builds")
+            for transform in sorted({r["transform"] for r in rows}):
+                group = [r for r in rows if r["transform"] == transform]
+                means = " ".join(
+                    f"{name}={np.mean([r[f'{name}_ratio'] for r in group if r[f'{name}_ratio'] != '']):.2f}x"
+                    for name in BLOWUP_METRICS if any(r[f"{name}_ratio"] != "" for r in group))
+                print(f"  {transform:<10} {means}")
+            print(f"Results saved to: {args.csv}")
+
+        elif args.command == "predict":
+            rows = blowup(store, args.corpus_dir)
+            models = {target: fit(rows, target) for target in ("compile_seconds", "binary_bytes")}
+            if not any(models.values()):
+                print(f" [Error] Fewer than two builds per transform in {args.store}; nothing to fit.")
+                return
+            for target, per_transform in models.items():
+                for transform, (slope, intercept, r2, n) in per_transform.items():
+                    print(f"{transform:<10} {target:<16} = {slope:.4g} * tokens + {intercept:.4g}  "
+                          f"(R^2 {r2:.3f}, {n} builds)")
+            for source in args.sources:
+                tokens = analyze_source(source.read_text(errors="replace"))[0]["tokens"]
+                for transform in sorted(set().union(*models.values())):
+                    guesses = [f"{target}={m[transform][0] * tokens + m[transform][1]:.4g}"
+                               for target, m in models.items() if transform in m]
+                    print(f"{source} ({tokens} tokens) {transform}: {' '.join(guesses)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,332 @@
+"""
+Table-driven x86-64 instruction decoder for the native analysis passes.
+
+This is not a disassembler: it recovers what CFG recovery, normalization and
+attribution need from every instruction -- its length, the opcode map/opcode,
+the ModRM operand fields, where the displacement and immediate bytes sit and
+their values, and the control-flow class with its direct target. Legacy,
+REX, VEX and EVEX encodings are handled; anything undecodable comes back as a
+one-byte BAD instruction so a linear sweep always makes progress.
+"""
+
+# Control-flow classes
+FLOW_NONE = 0
+FLOW_JMP = 1        # direct unconditional jump
+FLOW_JCC = 2        # direct conditional jump (incl. loop/jrcxz)
+FLOW_CALL = 3       # direct call
+FLOW_RET = 4
+FLOW_JMP_IND = 5    # jmp r/m
+FLOW_CALL_IND = 6   # call r/m
+FLOW_STOP = 7       # hlt / ud2 / int3: no fall-through
+FLOW_BAD = 8        # undecodable byte
+
+# Opcode maps
+MAP_1BYTE = 0
+MAP_0F = 1
+MAP_0F38 = 2
+MAP_0F3A = 3
+
+# Pseudo base register for RIP-relative operands
+REG_RIP = 16
+REG_RSP = 4
+REG_RBP = 5
+
+_PREFIXES = frozenset([0xF0, 0xF2, 0xF3, 0x2E, 0x36, 0x3E, 0x26, 0x64, 0x65, 0x66, 0x67])
+
+_MODRM_1 = set()
+for _base in range(0x00, 0x40, 0x08):
+    _MODRM_1.update(range(_base, _base + 4))
+_MODRM_1.update([0x62, 0x63, 0x69, 0x6B, 0xC0, 0xC1, 0xC6, 0xC7, 0xD0, 0xD1, 0xD2, 0xD3, 0xF6, 0xF7, 0xFE, 0xFF])
+_MODRM_1.update(range(0x80, 0x90))
+_MODRM_1.update(range(0xD8, 0xE0))
+_MODRM_1 = frozenset(_MODRM_1)
+
+# Immediate kinds: 1/2/4 fixed bytes, 'z' imm32 (imm16 with 0x66), 'v' imm32/imm64 (REX.W),
+# 'm' absolute moffs (8 bytes, 4 with 0x67), 'e' enter imm16+imm8
+_IMM_1 = {op: 1 for op in (0x04, 0x0C, 0x14, 0x1C, 0x24, 0x2C, 0x34, 0x3C, 0x6A, 0x6B, 0x80, 0x82, 0x83,
+                          0xA8, 0xC0, 0xC1, 0xC6, 0xCD, 0xD4, 0xD5, 0xE4, 0xE5, 0xE6, 0xE7)}
+_IMM_1.update({op: 1 for op in range(0xB0, 0xB8)})
+_IMM_1.update({op: "z" for op in (0x05, 0x0D, 0x15, 0x1D, 0x25, 0x2D, 0x35, 0x3D, 0x68, 0x69, 0x81, 0xA9, 0xC7)})
+_IMM_1.update({op: "v" for op in range(0xB8, 0xC0)})
+_IMM_1.update({op: "m" for op in range(0xA0, 0xA4)})
+_IMM_1.update({0xC2: 2, 0xCA: 2, 0xC8: "e"})
+
+_NO_MODRM_0F = set([0x05, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x0E, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37,
+                    0x77, 0xA0, 0xA1, 0xA2, 0xA8, 0xA9, 0xAA])
+_NO_MODRM_0F.update(range(0x80, 0x90))
+_NO_MODRM_0F.update(range(0xC8, 0xD0))
+_NO_MODRM_0F = frozenset(_NO_MODRM_0F)
+_IMM8_0F = frozenset([0x0F, 0x70, 0x71, 0x72, 0x73, 0xA4, 0xAC, 0xBA, 0xC2, 0xC4, 0xC5, 0xC6])
+
+
+class Insn:
+    """One decoded instruction. Register numbers include the REX/VEX extension bits."""
+
+    __slots__ = ("addr", "size", "map", "opcode", "prefixes", "rex", "vex",
+                 "modrm", "mod", "reg", "rm", "base", "index", "scale",
+                 "disp", "disp_off", "disp_size", "imm", "imm_off", "imm_size",
+                 "flow", "target")
+
+    def __init__(self, addr):
+        self.addr = addr
+        self.size = 1
+        self.map = MAP_1BYTE
+        self.opcode = 0
+        self.prefixes = ()
+        self.rex = 0
+        self.vex = False
+        self.modrm = -1
+        self.mod = self.reg = self.rm = -1
+        self.base = self.index = -1
+        self.scale = 1
+        self.disp = 0
+        self.disp_off = self.disp_size = 0
+        self.imm = 0
+        self.imm_off = self.imm_size = 0
+        self.flow = FLOW_NONE
+        self.target = None
+
+    @property
+    def end(self):
+        return self.addr + self.size
+
+    @property
+    def rex_w(self):
+        return bool(self.rex & 8)
+
+    @property
+    def has_memory_operand(self):
+        return self.modrm >= 0 and self.mod != 3
+
+    @property
+    def rip_relative(self):
+        return self.base == REG_RIP
+
+    @property
+    def is_nop(self):
+        return ((self.map == MAP_1BYTE and self.opcode == 0x90 and not self.rex & 1)
+                or (self.map == MAP_0F and self.opcode == 0x1F))
+
+    def key(self):
+        """Operand-free identity of the operation, for normalization and n-grams."""
+        group = self.reg & 7 if self.modrm >= 0 and _is_group(self.map, self.opcode) else -1
+        form = "m" if self.has_memory_operand else ("r" if self.modrm >= 0 else "")
+        return (self.map, self.opcode, group, form, 0x66 in self.prefixes, self.rex_w)
+
+
+def _is_group(map_, opcode):
+    """Opcodes whose ModRM.reg field selects the operation rather than a register."""
+    if map_ == MAP_1BYTE:
+        return opcode in (0x80, 0x81, 0x83, 0x8F, 0xC0, 0xC1, 0xC6, 0xC7, 0xD0, 0xD1, 0xD2, 0xD3,
+                          0xF6, 0xF7, 0xFE, 0xFF) or 0xD8 <= opcode <= 0xDF
+    if map_ == MAP_0F:
+        return opcode in (0x00, 0x01, 0x18, 0x1E, 0x1F, 0x71, 0x72, 0x73, 0xAE, 0xBA, 0xC7)
+    return False
+
+
+def _sext(value, bits):
+    sign = 1 << (bits - 1)
+    return (value ^ sign) - sign
+
+
+def decode(code, offset, addr):
+    """
+    Decode the instruction at code[offset], which lives at virtual address addr.
+
+    Args:
+        code: bytes / memoryview of a code section.
+        offset: position of the instruction inside code.
+        addr: virtual address of code[offset].
+
+    Returns:
+        Insn: never None; undecodable or truncated input yields FLOW_BAD of size 1.
+    """
+    insn = Insn(addr)
+    n = len(code)
+    p = offset
+    prefixes = []
+    try:
+        while code[p] in _PREFIXES:
+            prefixes.append(code[p])
+            p += 1
+        insn.prefixes = tuple(prefixes)
+        opsize16 = 0x66 in prefixes
+        addr32 = 0x67 in prefixes
+
+        rex = 0
+        b = code[p]
+        if 0x40 <= b <= 0x4F:
+            rex = b
+            p += 1
+            b = code[p]
+        insn.rex = rex
+        rex_r = 8 if rex & 4 else 0
+        rex_x = 8 if rex & 2 else 0
+        rex_b = 8 if rex & 1 else 0
+
+        map_ = MAP_1BYTE
+        has_modrm = False
+        imm = 0
+        if b in (0xC4, 0xC5, 0x62) and not rex:
+            # VEX (C4/C5) and EVEX (62) prefixes; the inverted R/X/B bits extend registers
+            insn.vex = True
+            p1 = code[p + 1]
+            rex_r = 0 if p1 & 0x80 else 8
+            if b == 0xC5:
+                map_ = MAP_0F
+                p += 2
+            elif b == 0xC4:
+                rex_x = 0 if p1 & 0x40 else 8
+                rex_b = 0 if p1 & 0x20 else 8
+                map_ = p1 & 0x1F
+                if code[p + 2] & 0x80:
+                    insn.rex = rex = 0x48
+                p += 3
+            else:
+                rex_x = 0 if p1 & 0x40 else 8
+                rex_b = 0 if p1 & 0x20 else 8
+                map_ = p1 & 0x07
+                if code[p + 2] & 0x80:
+                    insn.rex = rex = 0x48
+                p += 4
+            b = code[p]
+            p += 1
+            has_modrm = not (map_ == MAP_0F and b == 0x77)
+            if map_ == MAP_0F3A or (map_ == MAP_0F and b in _IMM8_0F):
+                imm = 1
+        elif b == 0x0F:
+            b = code[p + 1]
+            p += 2
+            if b == 0x38:
+                map_ = MAP_0F38
+                b = code[p]
+                p += 1
+                has_modrm = True
+            elif b == 0x3A:
+                map_ = MAP_0F3A
+                b = code[p]
+                p += 1
+                has_modrm = True
+                imm = 1
+            else:
+                map_ = MAP_0F
+                has_modrm = b not in _NO_MODRM_0F
+                if b in _IMM8_0F:
+                    imm = 1
+                elif 0x80 <= b <= 0x8F:
+                    insn.flow = FLOW_JCC
+                    imm = "rel32"
+                elif b == 0x0B:
+                    insn.flow = FLOW_STOP
+        else:
+            p += 1
+            has_modrm = b in _MODRM_1
+            imm = _IMM_1.get(b, 0)
+            if 0x70 <= b <= 0x7F or 0xE0 <= b <= 0xE3:
+                insn.flow = FLOW_JCC
+                imm = "rel8"
+            elif b == 0xEB:
+                insn.flow = FLOW_JMP
+                imm = "rel8"
+            elif b == 0xE9:
+                insn.flow = FLOW_JMP
+                imm = "rel32"
+            elif b == 0xE8:
+                insn.flow = FLOW_CALL
+                imm = "rel32"
+            elif b in (0xC2, 0xC3, 0xCA, 0xCB, 0xCF):
+                insn.flow = FLOW_RET
+            elif b in (0xF4, 0xCC):
+                insn.flow = FLOW_STOP
+        insn.map = map_
+        insn.opcode = b
+
+        if has_modrm:
+            modrm = code[p]
+            p += 1
+            mod = modrm >> 6
+            reg = ((modrm >> 3) & 7) | rex_r
+            rm = modrm & 7
+            insn.modrm = modrm
+            insn.mod = mod
+            insn.reg = reg
+            insn.rm = rm | rex_b
+            if mod != 3:
+                disp_size = 1 if mod == 1 else (4 if mod == 2 else 0)
+                if rm == 4:
+                    sib = code[p]
+                    p += 1
+                    base = sib & 7
+                    index = ((sib >> 3) & 7) | rex_x
+                    insn.scale = 1 << (sib >> 6)
+                    insn.index = index if index != 4 else -1
+                    if base == 5 and mod == 0:
+                        insn.base = -1
+                        disp_size = 4
+                    else:
+                        insn.base = base | rex_b
+                elif rm == 5 and mod == 0:
+                    insn.base = REG_RIP
+                    disp_size = 4
+                else:
+                    insn.base = rm | rex_b
+                if disp_size:
+                    insn.disp_off = p - offset
+                    insn.disp_size = disp_size
+                    insn.disp = _sext(int.from_bytes(code[p:p + disp_size], "little"), disp_size * 8)
+                    p += disp_size
+
+            if map_ == MAP_1BYTE:
+                group = reg & 7
+                if b in (0xF6, 0xF7) and group in (0, 1):
+                    imm = 1 if b == 0xF6 else "z"
+                elif b == 0xFF:
+                    if group in (2, 3):
+                        insn.flow = FLOW_CALL_IND
+                    elif group in (4, 5):
+                        insn.flow = FLOW_JMP_IND
+
+        if imm:
+            if imm == "rel8" or imm == "rel32":
+                size = 1 if imm == "rel8" else 4
+                rel = _sext(int.from_bytes(code[p:p + size], "little"), size * 8)
+                insn.imm_off = p - offset
+                insn.imm_size = size
+                insn.imm = rel
+                p += size
+                insn.target = addr + (p - offset) + rel
+            else:
+                if imm == "z":
+                    size = 2 if opsize16 else 4
+                elif imm == "v":
+                    size = 8 if rex & 8 else (2 if opsize16 else 4)
+                elif imm == "m":
+                    size = 4 if addr32 else 8
+                elif imm == "e":
+                    size = 3
+                else:
+                    size = imm
+                insn.imm_off = p - offset
+                insn.imm_size = size
+                raw = int.from_bytes(code[p:p + size], "little")
+                insn.imm = raw if imm in ("m", "e") else _sext(raw, size * 8)
+                p += size
+        if p > n:
+            raise IndexError
+    except IndexError:
+        bad = Insn(addr)
+        bad.flow = FLOW_BAD
+        return bad
+
+    insn.size = p - offset
+    return insn
+
+
+def sweep(code, addr, start=0, end=None):
+    """Linear-sweep decode of code[start:end]; yields Insn objects in address order."""
+    end = len(code) if end is None else end
+    p = start
+    while p < end:
+        insn = decode(code, p, addr + p)
+        yield insn
+        p += insn.size